@@ -43,3 +43,7 @@ endif()
 # Packages
 ndtree_pkg(cppformat "-DFMT_HEADER_ONLY" "")
 ndtree_pkg(range-v3 "-DRANGES_SUPPRESS_IOTA_WARNING" "")
+
+# Threads (used by the parallel algorithms)
+find_package(Threads REQUIRED)
+set(CMAKE_CXX_LINK_FLAGS "${CMAKE_CXX_LINK_FLAGS} ${CMAKE_THREAD_LIBS_INIT}")
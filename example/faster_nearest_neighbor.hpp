@@ -31,6 +31,10 @@ struct points {
  private:
   void redistribute_points_to_children(node_idx n) noexcept {
     balanced_refine(tree_, n, [&](node_idx parent) {
+      // the tree might have grown while refining:
+      if (points_.size() < *tree_.capacity()) {
+        points_.resize(*tree_.capacity());
+      }
       if (points_[*parent].size() == 0) { return; }
 
       for (auto&& pi : points_[*parent]) {
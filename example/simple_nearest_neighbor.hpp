@@ -21,10 +21,10 @@ struct points {
   std::unordered_map<node_idx, stack_vector<vec<nd>, k>> points_;
 
  public:
-  /// The container will have a fixed capacity
-  /// The tree has more nodes than leaf nodes so 2*capacity is a valid but
-  /// very conservative estimate
-  points(uint_t capacity) : tree_(capacity * 2), points_(1.5 * capacity) {}
+  /// The container reserves memory for capacity points
+  /// The tree grows on demand, so we just reserve memory for as many nodes as
+  /// points as an initial estimate
+  points(uint_t capacity) : tree_(capacity), points_(1.5 * capacity) {}
 
   /// Push adds a point to the container
   void push(vec<nd> p) {
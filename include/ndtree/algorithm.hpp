@@ -1,7 +1,13 @@
 #pragma once
 /// \file algorithm.hpp
+#include <ndtree/algorithm/apply.hpp>
 #include <ndtree/algorithm/balanced_refine.hpp>
+#include <ndtree/algorithm/bfs_sort.hpp>
+#include <ndtree/algorithm/compact.hpp>
 #include <ndtree/algorithm/dfs_sort.hpp>
+#include <ndtree/algorithm/dfs_sort_permutation.hpp>
+#include <ndtree/algorithm/diff.hpp>
+#include <ndtree/algorithm/hilbert_sort.hpp>
 #include <ndtree/algorithm/node_at.hpp>
 #include <ndtree/algorithm/node_length.hpp>
 #include <ndtree/algorithm/node_level.hpp>
@@ -12,3 +18,4 @@
 #include <ndtree/algorithm/normalized_coordinates.hpp>
 #include <ndtree/algorithm/root_traversal.hpp>
 #include <ndtree/algorithm/shift_location.hpp>
+#include <ndtree/algorithm/swap_sibling_groups.hpp>
@@ -0,0 +1,45 @@
+#pragma once
+/// \file apply.hpp
+#include <ndtree/algorithm/diff.hpp>
+#include <ndtree/algorithm/node_at.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/static_const.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+struct apply_fn {
+  /// Applies the patch \p p to the tree \p t
+  ///
+  /// \pre \p t has the same nodes as the tree from which the patch was
+  /// computed (see diff)
+  ///
+  /// Time complexity: O(M L), where M is the number of operations and L the
+  /// level of their nodes (O(M) if the tree indexes the node at each
+  /// location, see tree::enable_location_index), plus the time of the
+  /// coarsenings.
+  template <typename Tree, uint_t nd>
+  void operator()(Tree& t, tree_patch<nd> const& p) const {
+    static_assert(Tree::dimension() == nd, "");
+    for (auto&& l : p.coarsened) {
+      const auto n = node_at(t, l);
+      NDTREE_ASSERT(n, "node at location {} not found", l);
+      t.coarsen_subtree(n);
+    }
+    for (auto&& l : p.refined) {
+      const auto n = node_at(t, l);
+      NDTREE_ASSERT(n, "node at location {} not found", l);
+      NDTREE_ASSERT(t.is_leaf(n), "node at location {} is not a leaf", l);
+      t.refine(n);
+    }
+  }
+};
+
+namespace {
+constexpr auto&& apply = static_const<apply_fn>::value;
+}  // namespace
+
+}  // namespace v1
+}  // namespace ndtree
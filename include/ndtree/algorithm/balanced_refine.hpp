@@ -38,7 +38,7 @@ struct balanced_refine_fn {
 };
 
 namespace {
-auto&& balanced_refine = static_const<balanced_refine_fn>::value;
+constexpr auto&& balanced_refine = static_const<balanced_refine_fn>::value;
 }  // namespace
 
 }  // namespace v1
@@ -0,0 +1,64 @@
+#pragma once
+/// \file bfs_sort.hpp
+#include <ndtree/algorithm/swap_sibling_groups.hpp>
+#include <ndtree/concepts.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/static_const.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+struct bfs_sort_fn {
+ private:
+  struct binary_fn_t {
+    template <typename A, typename B>
+    void operator()(A&&, B&&) const noexcept {}
+  };
+
+ public:
+  /// Sorts the tree in breadth-first (level) order, with the siblings of each
+  /// group sorted in Morton Z-Curve order
+  ///
+  /// After sorting, the nodes of each level are stored contiguously in memory
+  /// and the children groups of a level are stored in the same order as their
+  /// parents.
+  ///
+  /// \param t [in] Tree to be sorted
+  /// \param data_swap [in] Function (node, node) -> ignored that swaps data
+  ///                       between two tree nodes.
+  ///
+  /// Runtime complexity: O(N), where N is the number of nodes in the tree.
+  /// Space complexity: O(1).
+  ///
+  /// The algorithm visits the sibling groups in memory order starting at the
+  /// root. Every visited group is already at its correct position, so the
+  /// children groups of its nodes are swapped to the next positions not yet
+  /// assigned, which is the order in which a queue-based breadth-first
+  /// traversal would visit them.
+  ///
+  /// \post is_compact()
+  template <typename Tree, typename DataSwap = binary_fn_t,
+            CONCEPT_REQUIRES_(Function<DataSwap, node_idx, node_idx>{})>
+  void operator()(Tree& t, DataSwap&& data_swap = DataSwap{}) const noexcept {
+    // next position to be assigned:
+    siblings_idx should = 1_sg;
+    for (siblings_idx s = 0_sg; *s < *should; ++s) {
+      for (auto n : t.nodes(s) | t.with_children()) {
+        siblings_idx c_sg = t.children_group(n);
+        if (c_sg != should) {
+          swap_sibling_groups(t, c_sg, should, data_swap);
+        }
+        ++should;
+      }
+    }
+    NDTREE_ASSERT(t.is_compact(), "the tree must be compact after sorting");
+  }
+};
+
+namespace {
+constexpr auto&& bfs_sort = static_const<bfs_sort_fn>::value;
+}  // namespace
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,59 @@
+#pragma once
+/// \file compact.hpp
+#include <ndtree/algorithm/swap_sibling_groups.hpp>
+#include <ndtree/concepts.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/static_const.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+struct compact_fn {
+ private:
+  struct binary_fn_t {
+    template <typename A, typename B>
+    void operator()(A&&, B&&) const noexcept {}
+  };
+
+ public:
+  /// Makes the tree compact by moving the last sibling groups in use into the
+  /// free sibling groups (holes) before them
+  ///
+  /// \param t [in] Tree to be compacted
+  /// \param data_swap [in] Function (node, node) -> ignored that swaps data
+  ///                       between two tree nodes.
+  ///
+  /// Unlike dfs_sort, only the sibling groups past the end of the compact
+  /// range are moved, so the tree is in general not sorted afterwards.
+  ///
+  /// Runtime complexity: O(H * (2^nd + log_64(N)) + G / 64), where H is the
+  /// number of holes and G the number of sibling groups between the end of the
+  /// compact range and the last sibling group in use.
+  ///
+  /// \post is_compact()
+  template <typename Tree, typename DataSwap = binary_fn_t,
+            CONCEPT_REQUIRES_(Function<DataSwap, node_idx, node_idx>{})>
+  void operator()(Tree& t, DataSwap&& data_swap = DataSwap{}) const noexcept {
+    // after compaction all sibling groups in use lie in [0, end):
+    const auto end = t.sibling_group(t.size());
+    auto hole = t.first_free_sibling_group();
+    auto used = t.next_sibling_group_in_use(end);
+    while (*hole < *end) {
+      NDTREE_ASSERT(used != t.sibling_group_capacity(),
+                    "hole {} but no sibling group in use past {}", *hole,
+                    *end);
+      swap_sibling_groups(t, hole, used, data_swap);
+      hole = t.next_free_sibling_group(siblings_idx{*hole + 1});
+      used = t.next_sibling_group_in_use(siblings_idx{*used + 1});
+    }
+    NDTREE_ASSERT(t.is_compact(), "the tree must be compact after compaction");
+  }
+};
+
+namespace {
+constexpr auto&& compact = static_const<compact_fn>::value;
+}  // namespace
+
+}  // namespace v1
+}  // namespace ndtree
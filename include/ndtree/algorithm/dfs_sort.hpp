@@ -1,5 +1,6 @@
 #pragma once
 /// \file dfs_sort.hpp
+#include <ndtree/algorithm/swap_sibling_groups.hpp>
 #include <ndtree/concepts.hpp>
 #include <ndtree/types.hpp>
 #include <ndtree/utility/static_const.hpp>
@@ -10,22 +11,6 @@ inline namespace v1 {
 
 struct dfs_sort_fn {
  private:
-  /// Swaps data of each node between two sibling groups
-  ///
-  /// \param t         [in] Tree to be sorted
-  /// \param a         [in] Sibling groups to swap with \p b
-  /// \param b         [in] Sibling groups to swap with \p a
-  /// \param data_swap [in] Function (node, node) -> ignored that swaps data
-  ///                       between two nodes.
-  template <typename Tree, typename DataSwap,
-            CONCEPT_REQUIRES_(Function<DataSwap, node_idx, node_idx>{})>
-  static void swap_data(Tree& t, siblings_idx a, siblings_idx b,
-                        DataSwap&& data_swap) noexcept {
-    RANGES_FOR(auto&& s, ranges::view::zip(t.nodes(a), t.nodes(b))) {
-      data_swap(get<0>(s), get<1>(s));
-    }
-  }
-
   /// Sorts the sub-tree spanned by sibling group \s in depth-first order, with
   /// the siblings of each group sorted in Morton Z-Curve order.
   ///
@@ -57,8 +42,7 @@ struct dfs_sort_fn {
       siblings_idx c_sg = t.children_group(n);
 
       if (c_sg != should) {
-        t.swap(c_sg, should);
-        swap_data(t, c_sg, should, data_swap);
+        swap_sibling_groups(t, c_sg, should, data_swap);
         should = sort_impl(t, should, data_swap);
       } else {
         should = sort_impl(t, c_sg, data_swap);
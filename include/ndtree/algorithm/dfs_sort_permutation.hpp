@@ -0,0 +1,171 @@
+#pragma once
+/// \file dfs_sort_permutation.hpp
+#include <vector>
+#include <ndtree/concepts.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/parallel_for.hpp>
+#include <ndtree/utility/static_const.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+struct dfs_sort_permutation_fn {
+ private:
+  /// Writes the sibling groups below sibling group \p s to \p out in
+  /// depth-first order, with the siblings of each group sorted in Morton
+  /// Z-Curve order
+  ///
+  /// Space complexity: O(log(N)) stack frames.
+  template <typename Tree>
+  static void order_impl(Tree const& t, siblings_idx s,
+                         siblings_idx*& out) noexcept {
+    for (auto n : t.nodes(s) | t.with_children()) {
+      const auto c_sg = t.children_group(n);
+      *out++ = c_sg;
+      order_impl(t, c_sg, out);
+    }
+  }
+
+  /// Number of sibling groups below sibling group \p s
+  template <typename Tree>
+  static uint_t count_impl(Tree const& t, siblings_idx s) noexcept {
+    uint_t count = 0;
+    for (auto n : t.nodes(s) | t.with_children()) {
+      count += 1 + count_impl(t, t.children_group(n));
+    }
+    return count;
+  }
+
+  /// Visits the sibling groups below sibling group \p s, whose nodes are at
+  /// level \p l, in depth-first order down to the level \p frontier_level
+  ///
+  /// \p on_group is called with each children group of the nodes above the
+  /// frontier level, and \p on_frontier with each node with children at the
+  /// frontier level (whose sub-trees are not visited).
+  template <typename Tree, typename OnGroup, typename OnFrontier>
+  static void top_impl(Tree const& t, siblings_idx s, uint_t l,
+                       uint_t frontier_level, OnGroup& on_group,
+                       OnFrontier& on_frontier) noexcept {
+    for (auto n : t.nodes(s) | t.with_children()) {
+      if (l == frontier_level) {
+        on_frontier(n);
+        continue;
+      }
+      const auto c_sg = t.children_group(n);
+      on_group(c_sg);
+      top_impl(t, c_sg, l + 1, frontier_level, on_group, on_frontier);
+    }
+  }
+
+  /// Level of the nodes whose sub-trees are sorted concurrently
+  ///
+  /// First level with at least 8 nodes with children per thread (or the last
+  /// level with nodes with children).
+  template <typename Tree>
+  static uint_t frontier_level(Tree const& t, uint_t no_threads) {
+    std::vector<node_idx> level{0_n};
+    uint_t l = 0;
+    while (true) {
+      std::vector<node_idx> next;
+      for (auto&& n : level) {
+        if (t.is_leaf(n)) { continue; }
+        RANGES_FOR(auto&& c, t.children(n)) {
+          if (!t.is_leaf(c)) { next.push_back(c); }
+        }
+      }
+      const auto no_parents = static_cast<uint_t>(
+       count_if(level, [&](node_idx n) { return !t.is_leaf(n); }));
+      if (no_parents >= 8 * no_threads or next.empty()) { return l; }
+      level = std::move(next);
+      ++l;
+    }
+  }
+
+ public:
+  /// Sorts the tree in depth-first order, with the siblings of each group
+  /// sorted in Morton Z-Curve order, and returns the node permutation
+  ///
+  /// Unlike dfs_sort, which swaps the node data of every misplaced sibling
+  /// group, the target order is computed first and the tree arrays are
+  /// rebuilt with one sequential gather (see tree::permute). The node data
+  /// can then be sorted with one gather per data array:
+  ///
+  ///   auto perm = dfs_sort_permutation(t);
+  ///   for (std::size_t i = 0; i != perm.size(); ++i) {
+  ///     new_data[i] = old_data[*perm[i]];
+  ///   }
+  ///
+  /// The work is split among \p no_threads threads: the sub-trees below a
+  /// frontier level are independent, and once their sizes are known (computed
+  /// concurrently bottom-up) the offset of each sub-tree in the sorted order
+  /// is known, and their depth-first orders are computed concurrently.
+  ///
+  /// \param t [in] Tree to be sorted
+  /// \param no_threads [in] Number of threads (default: 1)
+  ///
+  /// \returns node permutation: the node at position i after sorting was the
+  /// node result[i] before.
+  ///
+  /// Runtime complexity: O(N / no_threads + F), where N is the number of nodes
+  /// in the tree and F the number of nodes above the frontier level.
+  /// Space complexity: O(N).
+  ///
+  /// \post is_compact() && is_sorted()
+  template <typename Tree>
+  std::vector<node_idx> operator()(Tree& t, uint_t no_threads = 1) const {
+    std::vector<siblings_idx> order(*t.sibling_group(t.size()));
+    order[0] = 0_sg;
+    const uint_t fl = frontier_level(t, no_threads);
+
+    // 1) nodes with children at the frontier level, in depth-first order:
+    std::vector<node_idx> frontier;
+    {
+      auto on_group = [](siblings_idx) {};
+      auto on_frontier = [&](node_idx n) { frontier.push_back(n); };
+      top_impl(t, 0_sg, 0, fl, on_group, on_frontier);
+    }
+    const auto no_subtrees = static_cast<uint_t>(frontier.size());
+
+    // 2) number of sibling groups of each sub-tree:
+    std::vector<uint_t> offsets(no_subtrees);
+    parallel_for(no_threads, 0, no_subtrees, [&](uint_t i) {
+      offsets[i] = 1 + count_impl(t, t.children_group(frontier[i]));
+    });
+
+    // 3) order of the sibling groups above the frontier level, and offset of
+    // each sub-tree:
+    {
+      uint_t pos = 1;
+      uint_t i = 0;
+      auto on_group = [&](siblings_idx s) { order[pos++] = s; };
+      auto on_frontier = [&](node_idx) {
+        const auto size = offsets[i];
+        offsets[i++] = pos;
+        pos += size;
+      };
+      top_impl(t, 0_sg, 0, fl, on_group, on_frontier);
+      NDTREE_ASSERT(pos == order.size(), "{} sibling groups sorted, but {} "
+                                         "are in use",
+                    pos, order.size());
+    }
+
+    // 4) order of the sibling groups of each sub-tree:
+    parallel_for(no_threads, 0, no_subtrees, [&](uint_t i) {
+      siblings_idx* out = order.data() + offsets[i];
+      const auto c_sg = t.children_group(frontier[i]);
+      *out++ = c_sg;
+      order_impl(t, c_sg, out);
+    });
+
+    return t.permute(order, no_threads);
+  }
+};
+
+namespace {
+constexpr auto&& dfs_sort_permutation
+ = static_const<dfs_sort_permutation_fn>::value;
+}  // namespace
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,126 @@
+#pragma once
+/// \file diff.hpp
+#include <vector>
+#include <ndtree/location/default.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/detect.hpp>
+#include <ndtree/utility/static_const.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Modifications that transform an nd-tree into another one (see diff and
+/// apply)
+///
+/// The nodes are identified by their location, so a patch does not depend
+/// on the node indices of the trees, and can be applied to any tree with the
+/// same nodes as the one from which it was computed (e.g. to a replica).
+///
+/// Memory requirements: one location per coarsened or refined node.
+///
+template <uint_t nd> struct tree_patch {
+  using location_t = location::default_location<nd>;
+
+  /// Nodes whose subtrees are coarsened
+  std::vector<location_t> coarsened;
+  /// Nodes that are refined, parents before children (applied after the
+  /// coarsenings)
+  std::vector<location_t> refined;
+
+  /// Number of operations
+  uint_t size() const noexcept {
+    return static_cast<uint_t>(coarsened.size() + refined.size());
+  }
+
+  /// Does the patch leave the tree unchanged?
+  bool empty() const noexcept { return size() == 0; }
+};
+
+struct diff_fn {
+ private:
+  /// Are the subtrees of node \p na of \p a and of node \p nb of \p b
+  /// equal?
+  ///
+  /// \pre both trees store subtree hashes
+  template <typename A, typename B>
+  static auto equal_subtrees(A const& a, node_idx na, B const& b,
+                             node_idx nb, int) noexcept
+   -> decltype(a.subtree_hash(na) == b.subtree_hash(nb)) {
+    return a.subtree_hash(na) == b.subtree_hash(nb);
+  }
+  template <typename A, typename B>
+  static bool equal_subtrees(A const&, node_idx, B const&, node_idx,
+                             long) noexcept {
+    return false;
+  }
+
+  /// Appends the node at location \p loc and its descendants with children
+  /// in \p b to the refined nodes of \p p
+  template <typename B, typename Patch, typename Loc>
+  static void refine_all(B const& b, node_idx n, Loc& loc, Patch& p) {
+    if (b.is_leaf(n)) { return; }
+    p.refined.push_back(loc);
+    for (uint_t i = 0; i != B::no_children(); ++i) {
+      loc.push(i);
+      refine_all(b, b.child(n, child_pos<B>{i}), loc, p);
+      loc.pop();
+    }
+  }
+
+  /// Appends the operations that transform the subtree of node \p na of
+  /// \p a into the subtree of node \p nb of \p b to \p p, where both nodes
+  /// are at location \p loc
+  ///
+  /// Subtrees with equal hashes are skipped if \p hashes is true.
+  template <typename A, typename B, typename Patch, typename Loc>
+  static void diff(A const& a, node_idx na, B const& b, node_idx nb, Loc& loc,
+                   Patch& p, bool hashes) {
+    if (hashes and equal_subtrees(a, na, b, nb, 0)) { return; }
+    if (b.is_leaf(nb)) {
+      if (!a.is_leaf(na)) { p.coarsened.push_back(loc); }
+      return;
+    }
+    if (a.is_leaf(na)) {
+      refine_all(b, nb, loc, p);
+      return;
+    }
+    for (uint_t i = 0; i != A::no_children(); ++i) {
+      loc.push(i);
+      diff(a, a.child(na, child_pos<A>{i}), b, b.child(nb, child_pos<B>{i}),
+           loc, p, hashes);
+      loc.pop();
+    }
+  }
+
+ public:
+  /// Patch that transforms the tree \p a into the tree \p b
+  ///
+  /// The patch contains one location per coarsened subtree and per refined
+  /// node, so its size is proportional to the change and not to the size of
+  /// the trees.
+  ///
+  /// If both trees store subtree hashes (see tree::enable_subtree_hashes),
+  /// the subtrees with equal hashes are skipped, e.g., to find the subtrees
+  /// of a tree that changed since a copy of it was taken (a checkpoint).
+  ///
+  /// Time complexity: O(C + M), where C is the number of nodes common to
+  /// both trees and M the number of refined nodes. O(K L + M) with subtree
+  /// hashes, where K is the number of changed subtrees and L their level.
+  template <typename A, typename B>
+  auto operator()(A const& a, B const& b) const {
+    static_assert(A::dimension() == B::dimension(), "");
+    tree_patch<A::dimension()> p;
+    typename tree_patch<A::dimension()>::location_t loc;
+    diff(a, 0_n, b, 0_n, loc, p,
+         detect::has_subtree_hashes(a) and detect::has_subtree_hashes(b));
+    return p;
+  }
+};
+
+namespace {
+constexpr auto&& diff = static_const<diff_fn>::value;
+}  // namespace
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,85 @@
+#pragma once
+/// \file hilbert_sort.hpp
+#include <ndtree/algorithm/swap_sibling_groups.hpp>
+#include <ndtree/concepts.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/bit.hpp>
+#include <ndtree/utility/static_const.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+struct hilbert_sort_fn {
+ private:
+  /// Sorts the sub-tree below node \p p in depth-first order, visiting the
+  /// children of each node along the Hilbert curve
+  ///
+  /// \param t [in] Tree to be sorted.
+  /// \param p [in] Node with children. All nodes below it will be sorted.
+  /// \param e [in] Entry point of the Hilbert curve within \p p.
+  /// \param d [in] Intra direction of the Hilbert curve within \p p.
+  /// \param should [in] Position of the children group of \p p.
+  /// \param data_swap [in] Function (node, node) -> ignored that swaps data
+  ///                       between two nodes.
+  ///
+  /// \returns position of the next children group
+  ///
+  /// \pre all sibling groups before \p should are at their correct position
+  template <typename Tree, typename DataSwap,
+            CONCEPT_REQUIRES_(Function<DataSwap, node_idx, node_idx>{})>
+  static siblings_idx sort_impl(Tree& t, node_idx p, uint_t e, uint_t d,
+                                siblings_idx should,
+                                DataSwap&& data_swap) noexcept {
+    constexpr uint_t nd = Tree::dimension();
+    const siblings_idx c_sg = t.children_group(p);
+    if (c_sg != should) { swap_sibling_groups(t, c_sg, should, data_swap); }
+    ++should;
+
+    for (uint_t w = 0; w != Tree::no_children(); ++w) {
+      const auto pip = bit::hilbert::position_in_parent(e, d, w, nd);
+      const node_idx c = t.child(p, child_pos<Tree>{pip});
+      if (t.is_leaf(c)) { continue; }
+      should = sort_impl(t, c, bit::hilbert::child_entry_point(e, d, w, nd),
+                         bit::hilbert::child_intra_direction(d, w, nd),
+                         should, data_swap);
+    }
+    return should;
+  }
+
+  struct binary_fn_t {
+    template <typename A, typename B>
+    void operator()(A&&, B&&) const noexcept {}
+  };
+
+ public:
+  /// Sorts the tree in depth-first order, with the children groups of each
+  /// sibling group sorted along a Hilbert curve
+  ///
+  /// The siblings within a group remain in Morton Z-Curve order, but the
+  /// sub-trees of the siblings are stored in the order in which the Hilbert
+  /// curve visits the siblings (see location::hilbert). Consecutive sub-trees
+  /// are then face neighbors.
+  ///
+  /// \param t [in] Tree to be sorted
+  /// \param data_swap [in] Function (node, node) -> ignored that swaps data
+  ///                       between two tree nodes.
+  ///
+  /// Runtime complexity: O(N), where N is the number of nodes in the tree.
+  /// Space complexity: O(log(N)) stack frames.
+  ///
+  /// \post is_compact()
+  template <typename Tree, typename DataSwap = binary_fn_t,
+            CONCEPT_REQUIRES_(Function<DataSwap, node_idx, node_idx>{})>
+  void operator()(Tree& t, DataSwap&& data_swap = DataSwap{}) const noexcept {
+    if (!t.is_leaf(0_n)) { sort_impl(t, 0_n, 0, 0, 1_sg, data_swap); }
+    NDTREE_ASSERT(t.is_compact(), "the tree must be compact after sorting");
+  }
+};
+
+namespace {
+constexpr auto&& hilbert_sort = static_const<hilbert_sort_fn>::value;
+}  // namespace
+
+}  // namespace v1
+}  // namespace ndtree
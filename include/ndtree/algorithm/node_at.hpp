@@ -1,7 +1,9 @@
 #pragma once
 /// \file node_at.hpp
+#include <type_traits>
 #include <ndtree/concepts.hpp>
 #include <ndtree/types.hpp>
+#include <ndtree/utility/detect.hpp>
 #include <ndtree/utility/static_const.hpp>
 
 namespace ndtree {
@@ -9,6 +11,21 @@ inline namespace v1 {
 //
 
 struct node_at_fn {
+ private:
+  /// Indexed node at the location \p loc
+  template <typename Tree, typename Loc>
+  static auto indexed_node_at(Tree const& t, Loc const& loc, int) noexcept
+   -> decltype(t.node_at(std::declval<typename Tree::location_t>())) {
+    using location_t = typename Tree::location_t;
+    if (loc.level() > location_t::max_level()) { return node_idx{}; }
+    return t.node_at(detect::to_location<location_t>(loc));
+  }
+  template <typename Tree, typename Loc>
+  static node_idx indexed_node_at(Tree const&, Loc const&, long) noexcept {
+    return node_idx{};
+  }
+
+ public:
   /// Index of node at level loc.level containing the location \p loc
   ///
   /// \param t [in] n-dimensional tree.
@@ -19,10 +36,16 @@ struct node_at_fn {
   /// found at the same level of \p loc or the location is invalid returns an
   /// invalid node
   ///
+  /// Time complexity: O(1) if the tree indexes the node at each location (see
+  /// tree::enable_location_index) and \p n is the root node, O(loc.level())
+  /// otherwise.
   template <typename Tree, typename Loc, CONCEPT_REQUIRES_(Location<Loc>{})>
   auto operator()(Tree const& t, Loc&& loc, node_idx n = 0_n) const noexcept
    -> node_idx {
     static_assert(Tree::dimension() == std::decay_t<Loc>::dimension(), "");
+    if (n == 0_n and detect::has_location_index(t)) {
+      return indexed_node_at(t, std::forward<Loc>(loc), 0);
+    }
     for (auto&& p : loc()) {
       n = t.child(n, child_pos<Tree>{p});
       if (!n) { return node_idx{}; }
@@ -3,6 +3,7 @@
 #include <ndtree/algorithm/root_traversal.hpp>
 #include <ndtree/concepts.hpp>
 #include <ndtree/types.hpp>
+#include <ndtree/utility/detect.hpp>
 #include <ndtree/utility/static_const.hpp>
 
 namespace ndtree {
@@ -10,15 +11,30 @@ inline namespace v1 {
 //
 
 struct node_level_fn {
+ private:
+  /// Cached level of the node \p n
+  template <typename Tree>
+  static auto cached_level(Tree const& tree, node_idx n, int) noexcept
+   -> decltype(tree.level(n)) {
+    return tree.level(n);
+  }
+  template <typename Tree>
+  static uint_t cached_level(Tree const&, node_idx, long) noexcept {
+    return 0;
+  }
+
+ public:
   /// Level of the node \p n within the tree \p tree
   ///
   /// \param tree [in] Tree.
   /// \param n [in] Node index.
   ///
-  /// Time complexity: O(log(N))
+  /// Time complexity: O(1) if the tree stores the level of its nodes (see
+  /// tree::enable_level_cache), O(log(N)) otherwise.
   /// Space complexity: O(1)
   template <typename Tree>
   auto operator()(Tree const& tree, node_idx n) const noexcept -> uint_t {
+    if (detect::has_level_cache(tree)) { return cached_level(tree, n, 0); }
     uint_t l = 0;
     root_traversal(tree, tree.parent(n), [&](node_idx) {
       ++l;
@@ -1,9 +1,11 @@
 #pragma once
 /// \file node_location.hpp
+#include <type_traits>
 #include <ndtree/algorithm/root_traversal.hpp>
 #include <ndtree/concepts.hpp>
 #include <ndtree/types.hpp>
 #include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/detect.hpp>
 #include <ndtree/utility/static_const.hpp>
 
 namespace ndtree {
@@ -11,10 +13,30 @@ inline namespace v1 {
 //
 
 struct node_location_fn {
+ private:
+  /// Cached location of the node \p n
+  template <typename Loc, typename Tree>
+  static auto cached_location(Tree const& t, node_idx n, int) noexcept
+   -> decltype(t.location(n), Loc{}) {
+    return detect::to_location<Loc>(t.location(n));
+  }
+  template <typename Loc, typename Tree>
+  static Loc cached_location(Tree const&, node_idx, long) noexcept {
+    return Loc{};
+  }
+
+ public:
   /// Location code of the node with index \p n within the tree \p t
+  ///
+  /// Time complexity: O(1) if the tree stores the location of its nodes (see
+  /// tree::enable_location_cache) and \p loc is the root location,
+  /// O(log(N)) otherwise.
   template <typename Tree, typename Loc, CONCEPT_REQUIRES_(Location<Loc>{})>
   auto operator()(Tree const& t, node_idx n, Loc loc) const noexcept -> Loc {
     NDTREE_ASSERT(n, "cannot compute the location of an invalid node");
+    if (loc.level() == 0 and detect::has_location_cache(t)) {
+      return cached_location<Loc>(t, n, 0);
+    }
 
     root_traversal(t, n, [&](node_idx i) {
       if (t.is_root(i)) { return false; }
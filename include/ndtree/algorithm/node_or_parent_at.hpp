@@ -1,7 +1,10 @@
 #pragma once
 /// \file node_or_parent_at.hpp
+#include <algorithm>
+#include <type_traits>
 #include <ndtree/types.hpp>
 #include <ndtree/concepts.hpp>
+#include <ndtree/utility/detect.hpp>
 #include <ndtree/utility/static_const.hpp>
 
 namespace ndtree {
@@ -14,6 +17,53 @@ struct node_or_parent_at_fn {
     uint_t level = 0_u;
   };
 
+ private:
+  /// Smallest indexed node containing \p loc: since the nodes containing loc
+  /// are the prefixes of loc up to some level, that level is found with a
+  /// binary search over the levels of loc.
+  template <typename Tree, typename Loc,
+            typename = decltype(std::declval<Tree const&>().node_at(
+             std::declval<typename Tree::location_t>()))>
+  static node indexed_node_or_parent_at(Tree const& t, Loc const& loc,
+                                        int) noexcept {
+    using location_t = typename Tree::location_t;
+    // nodes below the maximum level of location_t are not indexed:
+    uint_t hi = std::min(loc.level(), location_t::max_level());
+    const auto l = prefix<location_t>(loc, hi, std::is_same<location_t, Loc>{});
+    node result{0_n, 0_u};
+    uint_t lo = 0;
+    while (lo < hi) {
+      const uint_t mid = (lo + hi + 1) / 2;
+      const auto n = t.node_at(prefix<location_t>(l, mid, std::true_type{}));
+      if (n) {
+        lo = mid;
+        result = node{n, mid};
+      } else {
+        hi = mid - 1;
+      }
+    }
+    return result;
+  }
+  template <typename Tree, typename Loc>
+  static node indexed_node_or_parent_at(Tree const&, Loc const&,
+                                        long) noexcept {
+    return node{};
+  }
+
+  /// Prefix at level \p level of a location as a location of type L
+  template <typename L>
+  static L prefix(L l, uint_t level, std::true_type) noexcept {
+    l.value >>= L::dimension() * (l.level() - level);
+    return l;
+  }
+  template <typename L, typename Loc>
+  static L prefix(Loc const& loc, uint_t level, std::false_type) noexcept {
+    L l;
+    for (uint_t i = 1; i <= level; ++i) { l.push(loc[i]); }
+    return l;
+  }
+
+ public:
   /// Index of smallest node containing \p loc with level <= loc.level
   ///
   /// \param t [in] n-dimensional tree.
@@ -22,9 +72,14 @@ struct node_or_parent_at_fn {
   /// \returns node(index, level) of the smallest node containing \p loc with
   /// level <= loc.level
   ///
+  /// Time complexity: O(log(loc.level())) if the tree indexes the node at each
+  /// location (see tree::enable_location_index), O(loc.level()) otherwise.
   template <typename Tree, typename Loc, CONCEPT_REQUIRES_(Location<Loc>{})>
   auto operator()(Tree const& t, Loc&& loc) const noexcept -> node {
     static_assert(Tree::dimension() == ranges::uncvref_t<Loc>::dimension(), "");
+    if (detect::has_location_index(t)) {
+      return indexed_node_or_parent_at(t, loc, 0);
+    }
     node result{0_n, 0_u};
     for (auto&& p : loc()) {
       auto m = t.child(result.idx, typename Tree::child_pos{p});
@@ -0,0 +1,41 @@
+#pragma once
+/// \file swap_sibling_groups.hpp
+#include <ndtree/concepts.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/static_const.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+struct swap_sibling_groups_fn {
+  /// Swaps the memory location of the sibling groups \p a and \p b of the
+  /// tree \p t together with the data of their nodes
+  ///
+  /// \param t         [in] Tree
+  /// \param a         [in] Sibling group to swap with \p b
+  /// \param b         [in] Sibling group to swap with \p a
+  /// \param data_swap [in] Function (node, node) -> ignored that swaps data
+  ///                       between two nodes.
+  ///
+  /// \pre a != b, and neither a nor b are the root sibling group
+  ///
+  /// Time complexity: O(2^nd + log_64(N))
+  template <typename Tree, typename DataSwap,
+            CONCEPT_REQUIRES_(Function<DataSwap, node_idx, node_idx>{})>
+  void operator()(Tree& t, siblings_idx a, siblings_idx b,
+                  DataSwap&& data_swap) const noexcept {
+    t.swap(a, b);
+    RANGES_FOR(auto&& s, ranges::view::zip(t.nodes(a), t.nodes(b))) {
+      data_swap(get<0>(s), get<1>(s));
+    }
+  }
+};
+
+namespace {
+constexpr auto&& swap_sibling_groups
+ = static_const<swap_sibling_groups_fn>::value;
+}  // namespace
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,154 @@
+#pragma once
+/// \file concurrent_refinement.hpp Lock-free concurrent refinement
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/atomic.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Refinement phase in which many threads refine the leaves of a tree
+/// concurrently without taking locks
+///
+/// The free sibling groups for the phase are collected when it starts. Each
+/// refine reserves one of them with an atomic bump of a counter, writes its
+/// parent and its cached level and location, and publishes it by setting the
+/// first child of the refined node with a compare-and-swap with release
+/// semantics. The queries of the phase load the first children with acquire
+/// semantics, so threads reading the tree through them never observe a
+/// half-refined node. If two threads refine the same node, only one
+/// succeeds; the sibling group reserved by the other remains free.
+///
+/// The free sibling groups, the size, the location index, and the subtree
+/// hashes of the tree are updated when the phase finishes.
+///
+/// \pre while the phase lasts the tree is only accessed through it
+///
+template <typename Tree> struct concurrent_refinement {
+  using tree_t = Tree;
+  using index_t = typename Tree::index_t;
+
+ private:
+  tree_t& tree_;
+  /// Free sibling groups reserved for the phase (in increasing order)
+  std::vector<siblings_idx> free_;
+  /// Next free sibling group to reserve
+  std::atomic<uint_t> next_{0};
+  bool finished_ = false;
+
+  index_t* first_children() const noexcept {
+    return tree_.first_children_.get();
+  }
+  index_t* parents() const noexcept { return tree_.parents_.get(); }
+
+ public:
+  /// Starts a refinement phase of the tree \p t in which at most
+  /// \p max_no_refined nodes can be refined
+  ///
+  /// Reserves memory for the new nodes (node indices remain valid) and
+  /// for their locations in the location index, so that finishing the
+  /// phase does not allocate.
+  ///
+  /// Time complexity: O(M log_64(N)), where M is \p max_no_refined (O(N) if
+  /// the tree is reallocated).
+  concurrent_refinement(tree_t& t, uint_t max_no_refined) : tree_(t) {
+    const auto no_nodes
+     = *tree_.size() + max_no_refined * tree_t::no_children();
+    tree_.reserve(no_nodes);
+    tree_.reserve_location_index(no_nodes);
+    free_.reserve(max_no_refined);
+    const auto last = tree_.sibling_group_capacity();
+    for (auto s = tree_.first_free_sibling_group();
+         s != last and free_.size() != max_no_refined;
+         s = tree_.next_free_sibling_group(siblings_idx{*s + 1})) {
+      free_.push_back(s);
+    }
+  }
+
+  concurrent_refinement(concurrent_refinement const&) = delete;
+  concurrent_refinement& operator=(concurrent_refinement const&) = delete;
+
+  /// Finishes the phase (if it has not been finished)
+  ~concurrent_refinement() { finish(); }
+
+  /// Refines the leaf node \p p (thread-safe, lock-free)
+  ///
+  /// \returns the children group of \p p, or an invalid sibling group if
+  /// \p p is not a leaf (e.g. because another thread refined it) or if
+  /// max_no_refined nodes have already been refined in this phase
+  ///
+  /// \pre !is_free(p) and \p p was obtained from the queries of this phase
+  /// (or before the phase started)
+  siblings_idx refine(node_idx p) noexcept {
+    NDTREE_ASSERT(!finished_, "the refinement phase has finished");
+    if (!is_leaf(p)) { return siblings_idx{}; }
+    const uint_t i = next_.fetch_add(1, std::memory_order_relaxed);
+    if (i >= free_.size()) { return siblings_idx{}; }
+    const auto s = free_[i];
+
+    // no other thread can reach s before it is published:
+    parents()[*s] = tree_t::store(p);
+    tree_.update_level(s);
+    tree_.update_location(s);
+
+    if (!atomic::compare_exchange(first_children() + *p,
+                                  tree_t::invalid_index(),
+                                  tree_t::store(tree_t::first_node(s)))) {
+      parents()[*s] = tree_t::invalid_index();
+      return siblings_idx{};
+    }
+    return s;
+  }
+
+  /// \name Queries (thread-safe)
+  ///@{
+
+  /// Index of the group of children of node \p n
+  siblings_idx children_group(node_idx n) const noexcept {
+    const auto c = tree_t::load(atomic::load_acquire(first_children() + *n));
+    return c ? tree_t::sibling_group(c) : siblings_idx{};
+  }
+
+  /// Is node \p n a leaf node?
+  bool is_leaf(node_idx n) const noexcept { return !children_group(n); }
+
+  /// Index of the parent node of node \p n
+  node_idx parent(node_idx n) const noexcept { return tree_.parent(n); }
+
+  ///@}  // Queries
+
+  /// Finishes the refinement phase: marks the sibling groups in use and
+  /// updates the size, the location index, and the subtree hashes of the
+  /// tree
+  ///
+  /// \returns number of refined nodes
+  ///
+  /// \pre no thread is refining nodes
+  ///
+  /// Time complexity: O(M log_64(N)), where M is the number of refined nodes
+  /// (O(M L) with subtree hashes, where L is their maximum level).
+  uint_t finish() noexcept {
+    if (finished_) { return 0; }
+    finished_ = true;
+    const auto no_reserved = std::min(next_.load(), uint_t(free_.size()));
+    uint_t no_refined = 0;
+    for (uint_t i = 0; i != no_reserved; ++i) {
+      const auto s = free_[i];
+      if (!tree_.parent(s)) { continue; }
+      tree_.acquire_sibling_group(s);
+      tree_.index_locations(s);
+      tree_.update_subtree_hashes(tree_.parent(s));
+      ++no_refined;
+    }
+    tree_.first_free_sibling_group_
+     = tree_.next_free_sibling_group(tree_.first_free_sibling_group_);
+    return no_refined;
+  }
+};
+
+}  // namespace v1
+}  // namespace ndtree
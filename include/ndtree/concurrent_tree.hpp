@@ -0,0 +1,256 @@
+#pragma once
+/// \file concurrent_tree.hpp Tree with internal synchronization
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <ndtree/tree.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/parallel_for.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// nd-octree that can be refined and coarsened from multiple threads
+///
+/// Wraps a tree<nd, Index> and synchronizes its modifications with:
+///
+/// - striped locks: sibling group s is guarded by the stripe
+///   s % no_stripes(). The parent of s and the first children of the nodes
+///   of s are only accessed while holding its stripe (except while s is
+///   being allocated, when no other thread can reach it),
+/// - an allocator lock that guards the free sibling groups and the tree
+///   size. It is only held while a sibling group is taken from or returned
+///   to the free sibling groups: O(log_64(N)),
+/// - a structure lock that refine and coarsen share, and that is held
+///   exclusively while the tree grows or whole subtrees are coarsened.
+///
+/// Nodes in different regions of the tree can thus be refined and coarsened
+/// concurrently.
+///
+/// The level and location caches of the tree are supported. The location
+/// index and the subtree hashes are not thread-safe and are disabled.
+///
+/// \warning the indices of released nodes must not be used concurrently
+///
+template <int nd, typename Index> struct concurrent_tree {
+  using tree_t = tree<nd, Index>;
+
+ private:
+  struct stripe {
+    std::mutex mutex;
+    /// Avoids false sharing between neighboring stripes
+    char padding[64 - sizeof(std::mutex) % 64];
+  };
+
+  tree_t tree_;
+  uint_t no_stripes_;
+  std::unique_ptr<stripe[]> stripes_;
+  mutable std::mutex allocator_;
+  mutable std::shared_timed_mutex structure_;
+
+  using shared_lock = std::shared_lock<std::shared_timed_mutex>;
+  using exclusive_lock = std::unique_lock<std::shared_timed_mutex>;
+  using stripe_lock = std::unique_lock<std::mutex>;
+
+  /// Lock of the sibling group \p s
+  std::mutex& stripe_of(siblings_idx s) const noexcept {
+    return stripes_[*s % no_stripes_].mutex;
+  }
+
+  /// Lock of the sibling group of node \p n
+  std::mutex& stripe_of(node_idx n) const noexcept {
+    return stripe_of(tree_t::sibling_group(n));
+  }
+
+  /// Takes the first free sibling group
+  ///
+  /// \returns an invalid sibling group if the tree is full
+  siblings_idx allocate() noexcept {
+    std::lock_guard<std::mutex> g(allocator_);
+    const auto s = tree_.first_free_sibling_group_;
+    if (s == tree_.sibling_group_capacity()) { return siblings_idx{}; }
+    tree_.acquire_sibling_group(s);
+    tree_.first_free_sibling_group_
+     = tree_.next_free_sibling_group(siblings_idx{*s + 1});
+    return s;
+  }
+
+  /// Returns the sibling group \p s to the free sibling groups
+  void deallocate(siblings_idx s) noexcept {
+    std::lock_guard<std::mutex> g(allocator_);
+    tree_.release_sibling_group(s);
+    if (*s < *tree_.first_free_sibling_group_) {
+      tree_.first_free_sibling_group_ = s;
+    }
+  }
+
+  /// Grows the tree if it is full
+  ///
+  /// \returns false if the tree is full and cannot grow
+  bool grow() {
+    exclusive_lock g(structure_);
+    return tree_.grow_if_full();
+  }
+
+ public:
+  /// Wraps the tree \p t
+  ///
+  /// \param no_stripes [in] number of locks guarding the sibling groups
+  explicit concurrent_tree(tree_t t,
+                           uint_t no_stripes = 16 * hardware_concurrency())
+   : tree_(std::move(t))
+   , no_stripes_(std::max(no_stripes, uint_t{1}))
+   , stripes_(std::make_unique<stripe[]>(no_stripes_)) {
+    tree_.disable_location_index();
+    tree_.disable_subtree_hashes();
+  }
+
+  /// Creates a tree with capacity for at least \p node_capacity nodes and
+  /// initializes it with a root node
+  explicit concurrent_tree(uint_t node_capacity,
+                           uint_t no_stripes = 16 * hardware_concurrency())
+   : concurrent_tree(tree_t(node_capacity), no_stripes) {}
+
+  /// Number of locks guarding the sibling groups
+  uint_t no_stripes() const noexcept { return no_stripes_; }
+
+  /// \name Modification (thread-safe)
+  ///@{
+
+  /// Refines the leaf node \p p
+  ///
+  /// If the tree is full, its capacity is doubled while all other
+  /// modifications wait.
+  ///
+  /// \returns the children group of \p p, or an invalid sibling group if
+  /// \p p is not a leaf (e.g. because another thread refined it) or if the
+  /// tree cannot grow further due to its index type
+  ///
+  /// \pre !is_free(p)
+  siblings_idx refine(node_idx p) {
+    while (true) {
+      {
+        shared_lock sl(structure_);
+        std::lock_guard<std::mutex> g(stripe_of(p));
+        if (!tree_.is_leaf(p)) { return siblings_idx{}; }
+        const auto s = allocate();
+        if (s) {
+          tree_.link_children(p, s);
+          return s;
+        }
+      }
+      if (!grow()) { return siblings_idx{}; }
+    }
+  }
+
+  /// Coarsens the node \p p
+  ///
+  /// \returns true if \p p has been coarsened, false if \p p is a leaf or if
+  /// some of its children are not leaves (e.g. because another thread
+  /// refined them)
+  ///
+  /// \pre !is_free(p)
+  bool coarsen(node_idx p) noexcept {
+    shared_lock sl(structure_);
+    auto& pm = stripe_of(p);
+    while (true) {
+      siblings_idx cg;
+      {
+        std::lock_guard<std::mutex> g(pm);
+        cg = tree_.children_group(p);
+      }
+      if (!cg) { return false; }
+
+      // lock the stripes of p and of its children group without deadlocks:
+      auto& cm = stripe_of(cg);
+      stripe_lock pl(pm, std::defer_lock), cl(cm, std::defer_lock);
+      if (&pm == &cm) {
+        pl.lock();
+      } else {
+        std::lock(pl, cl);
+      }
+      // another thread coarsened p and refined it again in between: retry
+      if (tree_.children_group(p) != cg) { continue; }
+
+      if (!all_of(tree_.nodes(cg),
+                  [&](node_idx c) { return tree_.is_leaf(c); })) {
+        return false;
+      }
+      deallocate(tree_.unlink_children(p));
+      return true;
+    }
+  }
+
+  /// Coarsens the subtree rooted at node \p p
+  ///
+  /// All other modifications wait until the subtree has been released.
+  ///
+  /// \pre !is_free(p)
+  void coarsen_subtree(node_idx p) {
+    exclusive_lock g(structure_);
+    if (tree_.is_leaf(p)) { return; }
+    tree_.coarsen_subtree(p);
+  }
+
+  /// Increases the capacity of the tree to at least \p node_capacity nodes
+  void reserve(uint_t node_capacity) {
+    exclusive_lock g(structure_);
+    tree_.reserve(node_capacity);
+  }
+
+  ///@}  // Modification
+
+  /// \name Queries (thread-safe)
+  ///@{
+
+  /// Number of nodes in the tree
+  node_idx size() const noexcept {
+    // coarsen_subtree modifies the size under the exclusive structure lock:
+    shared_lock sl(structure_);
+    std::lock_guard<std::mutex> g(allocator_);
+    return tree_.size();
+  }
+
+  /// Maximum number of nodes that the tree can hold without reallocating
+  node_idx capacity() const noexcept {
+    shared_lock sl(structure_);
+    return tree_.capacity();
+  }
+
+  /// Index of the parent node of node \p n
+  node_idx parent(node_idx n) const noexcept {
+    shared_lock sl(structure_);
+    std::lock_guard<std::mutex> g(stripe_of(n));
+    return tree_.parent(n);
+  }
+
+  /// Index of the group of children of node \p n
+  siblings_idx children_group(node_idx n) const noexcept {
+    shared_lock sl(structure_);
+    std::lock_guard<std::mutex> g(stripe_of(n));
+    return tree_.children_group(n);
+  }
+
+  /// Is node \p n a leaf node?
+  bool is_leaf(node_idx n) const noexcept { return !children_group(n); }
+
+  ///@}  // Queries
+
+  /// \name Underlying tree (not synchronized)
+  ///
+  /// Only valid while no other thread modifies the tree, e.g., to run the
+  /// tree algorithms between adaptation phases.
+  ///
+  ///@{
+
+  tree_t const& underlying() const noexcept { return tree_; }
+  tree_t& underlying() noexcept { return tree_; }
+
+  ///@}  // Underlying tree
+};
+
+}  // namespace v1
+}  // namespace ndtree
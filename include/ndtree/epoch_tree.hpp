@@ -0,0 +1,513 @@
+#pragma once
+/// \file epoch_tree.hpp Tree with epoch-based (RCU-like) snapshots
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <ndtree/tree.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/atomic.hpp>
+#include <ndtree/utility/parallel_for.hpp>
+#include <ndtree/utility/ranges.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// nd-octree whose readers see consistent snapshots while a writer refines
+/// and coarsens it
+///
+/// Every modification advances the tree epoch. A reader pins the current
+/// epoch e (pin()) and obtains a snapshot that shows the tree exactly as it
+/// was at epoch e, without taking locks:
+///
+/// - each sibling group stores the epochs in which it was linked (born) and
+///   unlinked (retired); the snapshot at e only follows the links to groups
+///   with born <= e < retired,
+/// - refine publishes the children group of a node with a release store,
+/// - coarsen retires the children group but keeps it linked: it is released
+///   (and can be reused) only once every reader pinned before the retire
+///   epoch has finished,
+/// - when the tree grows, the previous arrays are released in the same way.
+///
+/// Snapshots implement the read-only tree interface, so the node algorithms
+/// (node_at, node_or_parent_at, node_neighbors, node_location, ...) work on
+/// them.
+///
+/// Modifications are serialized with a writer lock. Refining a node whose
+/// children were retired after the oldest pinned snapshot waits until that
+/// snapshot is released.
+///
+/// The location index and the subtree hashes of the tree are not
+/// thread-safe and are disabled.
+///
+template <int nd, typename Index> struct epoch_tree {
+  using tree_t = tree<nd, Index>;
+  using index_t = typename tree_t::index_t;
+  using indices_t = typename tree_t::indices_t;
+  using epoch_t = std::uint64_t;
+
+ private:
+  /// Epoch of the groups that have not been retired (and of free slots)
+  static constexpr epoch_t never() noexcept {
+    return std::numeric_limits<epoch_t>::max();
+  }
+
+  /// Arrays read by the snapshots
+  struct version {
+    index_t const* parents;
+    index_t const* first_children;
+    epoch_t const* born;
+    epoch_t const* retired;
+  };
+
+  /// Memory released when the tree grows
+  struct retired_memory {
+    epoch_t epoch;
+    std::unique_ptr<version> v;
+    indices_t parents;
+    indices_t first_children;
+    std::unique_ptr<epoch_t[]> born;
+    std::unique_ptr<epoch_t[]> retired;
+  };
+
+  /// Sibling group retired from a node
+  struct retired_group {
+    epoch_t epoch;
+    node_idx parent;
+    siblings_idx group;
+  };
+
+  tree_t tree_;
+  /// Epoch in which each sibling group was linked
+  std::unique_ptr<epoch_t[]> born_;
+  /// Epoch in which each sibling group was retired
+  std::unique_ptr<epoch_t[]> retired_;
+  std::unique_ptr<version> current_;
+  std::atomic<version const*> version_{nullptr};
+  std::atomic<epoch_t> epoch_{0};
+
+  /// Epoch pinned by each reader slot (never() if the slot is free)
+  std::unique_ptr<std::atomic<epoch_t>[]> readers_;
+  uint_t no_reader_slots_;
+
+  mutable std::mutex writer_;
+  std::deque<retired_group> retired_groups_;
+  std::vector<retired_memory> retired_memory_;
+
+  void publish_version() {
+    current_ = std::make_unique<version>(
+     version{tree_.parents_.get(), tree_.first_children_.get(), born_.get(),
+             retired_.get()});
+    version_.store(current_.get(), std::memory_order_release);
+  }
+
+  /// Children group of node \p n in the latest epoch
+  siblings_idx children_group_(node_idx n) const noexcept {
+    const auto s = tree_.children_group(n);
+    return s and retired_[*s] == never() ? s : siblings_idx{};
+  }
+
+  /// Oldest epoch that a reader may still use
+  epoch_t oldest_epoch() const noexcept {
+    epoch_t e = epoch_.load();
+    for (uint_t i = 0; i != no_reader_slots_; ++i) {
+      e = std::min(e, readers_[i].load());
+    }
+    return e;
+  }
+
+  /// Waits until no reader uses an epoch older than \p e
+  void wait_for_readers(epoch_t e) const noexcept {
+    while (oldest_epoch() < e) { std::this_thread::yield(); }
+  }
+
+  /// Releases the sibling groups and the memory retired before the oldest
+  /// epoch in use
+  void reclaim() noexcept {
+    const auto oldest = oldest_epoch();
+    auto first_children = tree_.first_children_.get();
+    while (!retired_groups_.empty()
+           and retired_groups_.front().epoch <= oldest) {
+      const auto r = retired_groups_.front();
+      retired_groups_.pop_front();
+      atomic::store_release(first_children + *r.parent,
+                            tree_t::invalid_index());
+      atomic::store_release(tree_.parents_.get() + *r.group,
+                            tree_t::invalid_index());
+      tree_.release_sibling_group(r.group);
+      if (*r.group < *tree_.first_free_sibling_group_) {
+        tree_.first_free_sibling_group_ = r.group;
+      }
+    }
+    retired_memory_.erase(
+     std::remove_if(retired_memory_.begin(), retired_memory_.end(),
+                    [&](retired_memory const& m) { return m.epoch <= oldest; }),
+     retired_memory_.end());
+  }
+
+  /// Per sibling group epochs of the capacity of the tree (copies the first
+  /// \p n elements of \p a)
+  std::unique_ptr<epoch_t[]> make_epochs(epoch_t const* a, uint_t n) const {
+    const auto m = *tree_.sibling_group_capacity();
+    auto r = std::make_unique<epoch_t[]>(m);
+    std::fill(r.get(), r.get() + m, never());
+    if (a) { std::copy(a, a + std::min(n, m), r.get()); }
+    return r;
+  }
+
+  /// Doubles the capacity of the tree
+  ///
+  /// \returns false if the tree cannot grow further due to its index type
+  bool grow() {
+    const auto cap = *tree_.sibling_group_capacity();
+    const auto max_cap = *tree_t::max_sibling_group_capacity();
+    if (cap == max_cap) { return false; }
+    const epoch_t w = epoch_.load() + 1;
+    auto old = tree_.reallocate(siblings_idx{std::min(2 * cap, max_cap)});
+    auto born = make_epochs(born_.get(), cap);
+    auto retired = make_epochs(retired_.get(), cap);
+    ranges::swap(born, born_);
+    ranges::swap(retired, retired_);
+    retired_memory_.push_back(retired_memory{
+     w, std::move(current_), std::move(old.first), std::move(old.second),
+     std::move(born), std::move(retired)});
+    publish_version();
+    epoch_.store(w);
+    return true;
+  }
+
+  /// Retires the descendants of node \p p in a new epoch
+  void coarsen_subtree_(node_idx p) {
+    if (!children_group_(p)) { return; }
+    const epoch_t w = epoch_.load() + 1;
+    retire_subtree(p, w);
+    epoch_.store(w);
+    reclaim();
+  }
+
+  /// Retires the children group of node \p p and of all its descendants
+  void retire_subtree(node_idx p, epoch_t w) {
+    const auto s = children_group_(p);
+    if (!s) { return; }
+    RANGES_FOR(auto&& c, tree_t::nodes(s)) { retire_subtree(c, w); }
+    atomic::store_release(retired_.get() + *s, w);
+    retired_groups_.push_back(retired_group{w, p, s});
+  }
+
+ public:
+  /// Wraps the tree \p t
+  ///
+  /// \param max_no_readers [in] maximum number of simultaneously pinned
+  /// snapshots (further readers wait for a free slot)
+  explicit epoch_tree(tree_t t,
+                      uint_t max_no_readers = 4 * hardware_concurrency())
+   : tree_(std::move(t))
+   , no_reader_slots_(std::max(max_no_readers, uint_t{1})) {
+    tree_.disable_location_index();
+    tree_.disable_subtree_hashes();
+    born_ = make_epochs(nullptr, 0);
+    retired_ = make_epochs(nullptr, 0);
+    const auto cap = *tree_.sibling_group_capacity();
+    for (uint_t i = 0; i != cap; ++i) {
+      if (!tree_.is_free(siblings_idx{i})) { born_[i] = 0; }
+    }
+    readers_ = std::make_unique<std::atomic<epoch_t>[]>(no_reader_slots_);
+    for (uint_t i = 0; i != no_reader_slots_; ++i) {
+      readers_[i].store(never());
+    }
+    publish_version();
+  }
+
+  /// Creates a tree with capacity for at least \p node_capacity nodes and
+  /// initializes it with a root node
+  explicit epoch_tree(uint_t node_capacity,
+                      uint_t max_no_readers = 4 * hardware_concurrency())
+   : epoch_tree(tree_t(node_capacity), max_no_readers) {}
+
+  epoch_tree(epoch_tree const&) = delete;
+  epoch_tree& operator=(epoch_tree const&) = delete;
+
+  /// Current epoch (number of modifications)
+  epoch_t epoch() const noexcept { return epoch_.load(); }
+
+  /// \name Snapshots (readers)
+  ///@{
+
+  /// Read-only view of the tree at a given epoch
+  ///
+  /// The node and sibling group indices of a snapshot are those of the tree
+  /// at its epoch.
+  struct snapshot {
+   private:
+    epoch_tree const* tree_ = nullptr;
+    version const* v_ = nullptr;
+    uint_t slot_ = 0;
+    epoch_t epoch_ = 0;
+
+    friend epoch_tree;
+    snapshot(epoch_tree const* t, uint_t slot, epoch_t e) noexcept
+     : tree_(t)
+     , v_(t->version_.load(std::memory_order_acquire))
+     , slot_(slot)
+     , epoch_(e) {}
+
+   public:
+    snapshot(snapshot&& other) noexcept
+     : tree_(other.tree_), v_(other.v_), slot_(other.slot_),
+       epoch_(other.epoch_) {
+      other.tree_ = nullptr;
+    }
+    snapshot& operator=(snapshot&& other) noexcept {
+      release();
+      tree_ = other.tree_;
+      v_ = other.v_;
+      slot_ = other.slot_;
+      epoch_ = other.epoch_;
+      other.tree_ = nullptr;
+      return *this;
+    }
+    snapshot(snapshot const&) = delete;
+    snapshot& operator=(snapshot const&) = delete;
+    ~snapshot() { release(); }
+
+    /// Unpins the epoch of the snapshot
+    void release() noexcept {
+      if (!tree_) { return; }
+      tree_->readers_[slot_].store(never(), std::memory_order_release);
+      tree_ = nullptr;
+    }
+
+    /// Epoch of the snapshot
+    epoch_t epoch() const noexcept { return epoch_; }
+
+    /// \name Spatial constants
+    ///@{
+
+    static constexpr int_t dimension() noexcept { return nd; }
+    static constexpr auto dimensions() noexcept {
+      return tree_t::dimensions();
+    }
+    static constexpr uint_t no_children() noexcept {
+      return tree_t::no_children();
+    }
+    static constexpr uint_t position_in_parent(node_idx n) noexcept {
+      return tree_t::position_in_parent(n);
+    }
+
+    ///@}  // Spatial constants
+
+    /// \name Graph edges (parent/children)
+    ///@{
+
+    using child_pos = typename tree_t::child_pos;
+
+    static constexpr siblings_idx sibling_group(node_idx n) noexcept {
+      return tree_t::sibling_group(n);
+    }
+    static constexpr bool is_root(node_idx n) noexcept {
+      return tree_t::is_root(n);
+    }
+
+    /// Index of the parent node of the sibling group \p s
+    node_idx parent(siblings_idx s) const noexcept {
+      NDTREE_ASSERT(tree_, "the snapshot has been released");
+      return tree_t::load(atomic::load_acquire(v_->parents + *s));
+    }
+
+    /// Index of the parent node of node \p n
+    node_idx parent(node_idx n) const noexcept {
+      return parent(sibling_group(n));
+    }
+
+    /// Index of the first child of node \p n
+    node_idx first_child(node_idx n) const noexcept {
+      NDTREE_ASSERT(tree_, "the snapshot has been released");
+      const auto c
+       = tree_t::load(atomic::load_acquire(v_->first_children + *n));
+      if (!c) { return c; }
+      // retired is read first: a reused group stores its new born epoch
+      // before it becomes live again
+      const auto s = *sibling_group(c);
+      if (atomic::load_acquire(v_->retired + s) <= epoch_
+          or atomic::load_acquire(v_->born + s) > epoch_) {
+        return node_idx{};
+      }
+      return c;
+    }
+
+    /// Index of the group of children of node \p n
+    siblings_idx children_group(node_idx n) const noexcept {
+      auto c = first_child(n);
+      return c ? sibling_group(c) : siblings_idx{};
+    }
+
+    /// Range of child positions: [0, no_children)
+    static constexpr auto child_positions() noexcept {
+      return child_pos::rng();
+    }
+
+    /// Child node at position \p p of node \p n
+    node_idx child(node_idx n, child_pos p) const noexcept {
+      const auto fc = first_child(n);
+      return fc ? node_idx{*fc + *p} : fc;
+    }
+
+    /// Range of children nodes of node \p n
+    auto children(node_idx n) const noexcept {
+      const auto fc = first_child(n);
+      return fc ? boxed_ints<node_idx>(*fc, *fc + no_children())
+                : boxed_ints<node_idx>(0_n, 0_n);
+    }
+
+    /// Is node \p n a leaf node?
+    bool is_leaf(node_idx n) const noexcept { return !first_child(n); }
+
+    /// Number of childrens of the node \p n
+    uint_t no_children(node_idx n) const noexcept {
+      return is_leaf(n) ? 0 : no_children();
+    }
+
+    /// Nodes in sibling group \p s
+    static constexpr auto nodes(siblings_idx s) noexcept {
+      return tree_t::nodes(s);
+    }
+
+    /// Range filter that selects leaf nodes only
+    auto leaf() const noexcept {
+      return view::filter([&](node_idx i) { return is_leaf(i); });
+    }
+
+    /// Range filter that selects nodes with children only
+    auto with_children() const noexcept {
+      return view::remove_if([&](node_idx i) { return is_leaf(i); });
+    }
+
+    ///@}  // Graph edges
+  };
+
+  /// Pins the current epoch and returns a snapshot of the tree at it
+  ///
+  /// Lock-free unless all reader slots are in use.
+  snapshot pin() const noexcept {
+    const uint_t first
+     = std::hash<std::thread::id>{}(std::this_thread::get_id())
+       % no_reader_slots_;
+    for (uint_t i = first;; i = (i + 1) % no_reader_slots_) {
+      auto e = epoch_.load();
+      epoch_t free = never();
+      if (readers_[i].compare_exchange_strong(free, e)) {
+        // a writer that did not see the slot may have released groups
+        // retired before the current epoch: pin the current one
+        for (auto c = epoch_.load(); c != e; c = epoch_.load()) {
+          readers_[i].store(c);
+          e = c;
+        }
+        return snapshot(this, i, e);
+      }
+      if ((i + 1) % no_reader_slots_ == first) { std::this_thread::yield(); }
+    }
+  }
+
+  ///@}  // Snapshots
+
+  /// \name Modification (writers)
+  ///@{
+
+  /// Refines the leaf node \p p
+  ///
+  /// \returns the children group of \p p, or an invalid sibling group if the
+  /// tree cannot grow further due to its index type
+  ///
+  /// \pre !is_free(p) && p is a leaf in the current epoch
+  /// \warning waits for the readers pinned before the last coarsening of
+  /// \p p (if its children have not been released yet): the calling thread
+  /// must not hold such a snapshot
+  siblings_idx refine(node_idx p) {
+    std::lock_guard<std::mutex> g(writer_);
+    NDTREE_ASSERT(!children_group_(p), "node {} is not a leaf", *p);
+    reclaim();
+    if (const auto s = tree_.children_group(p)) {
+      wait_for_readers(retired_[*s]);
+      reclaim();
+    }
+    if (tree_.size() == tree_.capacity() and !grow()) {
+      return siblings_idx{};
+    }
+
+    const epoch_t w = epoch_.load() + 1;
+    const auto s = tree_.first_free_sibling_group_;
+    tree_.acquire_sibling_group(s);
+    tree_.first_free_sibling_group_
+     = tree_.next_free_sibling_group(siblings_idx{*s + 1});
+    // snapshots read these concurrently: publish them before the first child
+    atomic::store_release(born_.get() + *s, w);
+    atomic::store_release(retired_.get() + *s, never());
+    atomic::store_release(tree_.parents_.get() + *s, tree_t::store(p));
+    tree_.update_level(s);
+    tree_.update_location(s);
+    atomic::store_release(tree_.first_children_.get() + *p,
+                          tree_t::store(tree_t::first_node(s)));
+    epoch_.store(w);
+    return s;
+  }
+
+  /// Coarsens the subtree rooted at node \p p
+  ///
+  /// The released sibling groups can be reused once all snapshots pinned
+  /// before this call have been released.
+  ///
+  /// \pre !is_free(p)
+  void coarsen_subtree(node_idx p) {
+    std::lock_guard<std::mutex> g(writer_);
+    coarsen_subtree_(p);
+  }
+
+  /// Coarsens the node \p p
+  ///
+  /// \pre !is_free(p) && all children of \p p are leaves
+  void coarsen(node_idx p) {
+    std::lock_guard<std::mutex> g(writer_);
+    NDTREE_ASSERT(all_of(tree_.children(p),
+                         [&](node_idx c) { return !children_group_(c); }),
+                  "node {}: has non-leaf children", *p);
+    coarsen_subtree_(p);
+  }
+
+  /// Waits until all snapshots pinned before this call have been released,
+  /// and releases the sibling groups retired before it
+  ///
+  /// \warning the calling thread must not hold a snapshot
+  void synchronize() {
+    std::lock_guard<std::mutex> g(writer_);
+    wait_for_readers(epoch_.load());
+    reclaim();
+  }
+
+  ///@}  // Modification
+
+  /// Number of nodes in the current epoch
+  node_idx size() const noexcept {
+    std::lock_guard<std::mutex> g(writer_);
+    return node_idx{*tree_.size()
+                    - static_cast<uint_t>(retired_groups_.size())
+                       * tree_t::no_children()};
+  }
+
+  /// Underlying tree (not synchronized)
+  ///
+  /// It still contains the sibling groups that have been retired but not
+  /// released yet (see synchronize). Only valid while no other thread uses
+  /// the tree.
+  tree_t const& underlying() const noexcept { return tree_; }
+};
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,230 @@
+#pragma once
+/// \file frozen_tree.hpp Immutable succinct nd-octree
+#include <type_traits>
+#include <ndtree/concepts.hpp>
+#include <ndtree/relations/dimension.hpp>
+#include <ndtree/relations/tree.hpp>
+#include <ndtree/serialization/succinct.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/bounded.hpp>
+#include <ndtree/utility/rank_select.hpp>
+#include <ndtree/utility/ranges.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Immutable nd-octree stored as a LOUDS bitvector
+///
+/// \tparam nd Number of spatial dimensions
+///
+/// The tree is stored as one "refined?" bit per node in breadth-first order
+/// (level-order unary degree sequence: since every refined node has exactly
+/// 2^nd children, one bit per node suffices). The node indices are the
+/// breadth-first positions of the nodes, that is, they are the node indices
+/// of the tree after bfs_sort, and the layout of the sibling groups is the
+/// same as in tree:
+///
+/// - first_child(n) = 1 + rank1(n) * 2^nd, if bit n is set,
+/// - parent(s) = select1(s - 1), for sibling groups s > 0.
+///
+/// Memory requirements: ~1.2 bits per node (see rank_select_bitvector).
+///
+/// The read-only interface is that of tree, so the algorithms templated on
+/// the Tree type (node_at, node_or_parent_at, node_location, node_neighbors,
+/// ...) work on frozen trees.
+template <int nd> struct frozen_tree {
+ private:
+  /// Bit n is set if node n is refined
+  rank_select_bitvector refined_;
+
+ public:
+  /// \name Spatial constants
+  ///@{
+
+  /// Number of spatial dimensions of the tree
+  static constexpr int_t dimension() noexcept { return nd; }
+
+  /// Range of spatial dimensions of the tree: [0, nd)
+  static constexpr auto dimensions() noexcept {
+    return ndtree::dimensions(dimension());
+  }
+
+  /// Number of children per node
+  static constexpr uint_t no_children() noexcept {
+    return ndtree::no_children(nd);
+  }
+
+  /// Position of node \p n within its parent
+  static constexpr uint_t position_in_parent(node_idx n) noexcept {
+    return ((*n) - 1_u) % no_children();
+  }
+
+  ///@}  // Spatial constants
+
+  /// \name Graph edges (parent/children)
+  ///
+  /// Time complexity: O(1) (parent: see rank_select_bitvector::select1)
+  ///
+  ///@{
+
+  /// Child position type is a uint_t bounded in [0, no_children)
+  using child_pos = bounded<uint_t, 0, no_children(), struct child_pos_tag>;
+
+  /// Index of the sibling group of node \p n
+  static constexpr siblings_idx sibling_group(node_idx n) noexcept {
+    return siblings_idx{*n == 0 ? 0 : (*n - 1) / no_children() + 1};
+  }
+
+  /// First node in sibling group \p s
+  static constexpr node_idx first_node(siblings_idx s) noexcept {
+    return (*s == 0) ? 0_n : node_idx{1 + no_children() * (*s - 1)};
+  }
+
+  /// Is \p s the sibling group of the root node?
+  static constexpr bool is_root(siblings_idx s) noexcept { return *s == 0; }
+
+  /// Is \p n the root node?
+  static constexpr bool is_root(node_idx n) noexcept { return *n == 0; }
+
+  /// Index of the parent node of the sibling group \p s
+  node_idx parent(siblings_idx s) const noexcept {
+    NDTREE_ASSERT(s, "cannot obtain parent of invalid sibling group");
+    NDTREE_ASSERT(*s <= refined_.count(), "sg {} is out-of-bounds [0, {})",
+                  *s, refined_.count() + 1);
+    return is_root(s) ? node_idx{} : node_idx{refined_.select1(*s - 1)};
+  }
+
+  /// Index of the parent node of node \p n
+  node_idx parent(node_idx n) const noexcept {
+    return parent(sibling_group(n));
+  }
+
+  /// Index of the first child of node \p n
+  node_idx first_child(node_idx n) const noexcept {
+    NDTREE_ASSERT(n, "cannot obtain first child of invalid node");
+    NDTREE_ASSERT(n < size(), "node {} is out-of-bounds [0, {})", n, size());
+    return refined_[*n] ? node_idx{1 + refined_.rank1(*n) * no_children()}
+                        : node_idx{};
+  }
+
+  /// Index of the group of children of node \p n
+  siblings_idx children_group(node_idx n) const noexcept {
+    auto c = first_child(n);
+    return c ? sibling_group(c) : siblings_idx{};
+  }
+
+  /// Range of child positions: [0, no_children)
+  static constexpr auto child_positions() noexcept { return child_pos::rng(); }
+
+  /// Child node at position \p p of node \p n
+  node_idx child(node_idx n, child_pos p) const noexcept {
+    const auto fc = first_child(n);
+    return fc ? node_idx{*fc + *p} : fc;
+  }
+
+  /// Range of children nodes of node \p n
+  auto children(node_idx n) const noexcept {
+    const auto fc = first_child(n);
+    return fc ? boxed_ints<node_idx>(*fc, *fc + no_children())
+              : boxed_ints<node_idx>(0_n, 0_n);
+  }
+
+  /// Is node \p n a leaf node? (That is, does it have zero children?)
+  bool is_leaf(node_idx n) const noexcept {
+    NDTREE_ASSERT(n < size(), "node {} is out-of-bounds [0, {})", n, size());
+    return !refined_[*n];
+  }
+
+  /// Number of childrens of the node \p n
+  uint_t no_children(node_idx n) const noexcept {
+    return is_leaf(n) ? 0 : no_children();
+  }
+
+  ///@}  // Graph edges
+
+  /// \name Node ranges
+  ///@{
+
+  /// Nodes in sibling group \p s
+  static constexpr auto nodes(siblings_idx s) noexcept {
+    const auto fn = first_node(s);
+    return !is_root(s) ? boxed_ints<node_idx>(*fn, *fn + no_children())
+                       : boxed_ints<node_idx>(0_n, 1_n);
+  }
+
+  /// All nodes of the tree
+  auto operator()() const noexcept {
+    return boxed_ints<node_idx>(0_n, size());
+  }
+
+  /// All nodes of the tree
+  auto nodes() const noexcept { return (*this)(); }
+
+  /// Range filter that selects leaf nodes only
+  auto leaf() const noexcept {
+    return view::filter([&](node_idx i) { return is_leaf(i); });
+  }
+
+  /// Range filter that selects nodes with children only
+  auto with_children() const noexcept {
+    return view::remove_if([&](node_idx i) { return is_leaf(i); });
+  }
+
+  ///@}  // Node ranges
+
+  /// Number of nodes in the tree
+  node_idx size() const noexcept { return node_idx{refined_.size()}; }
+
+  /// Is the tree empty?
+  bool empty() const noexcept { return size() == 0_n; }
+
+  /// Number of nodes in the tree (frozen trees are always compact)
+  node_idx capacity() const noexcept { return size(); }
+
+  /// Frozen trees are always compact
+  static constexpr bool is_compact() noexcept { return true; }
+
+  /// Number of sibling groups of the tree
+  siblings_idx sibling_group_capacity() const noexcept {
+    return siblings_idx{empty() ? 0 : refined_.count() + 1};
+  }
+
+  /// Memory used by the tree in bytes
+  ///
+  /// Time complexity: O(1)
+  uint_t memory_usage() const noexcept { return refined_.memory_usage(); }
+
+  frozen_tree() = default;
+
+  /// Freezes the breadth-first succinct encoding \p e
+  ///
+  /// \pre e.traversal == order::bfs
+  ///
+  /// Time complexity: O(N / 64)
+  explicit frozen_tree(serialization::succinct::encoding e)
+   : refined_(std::move(e.words), e.size) {
+    NDTREE_ASSERT(e.traversal == serialization::succinct::order::bfs,
+                  "frozen trees require a breadth-first encoding");
+    NDTREE_ASSERT(empty() or *size() == 1 + refined_.count() * no_children(),
+                  "invalid encoding: {} nodes, {} refined", *size(),
+                  refined_.count());
+  }
+
+  /// Freezes the tree \p t
+  ///
+  /// The node n of the frozen tree is the node n of \p t after bfs_sort.
+  ///
+  /// Time complexity: O(N)
+  template <typename Tree,
+            CONCEPT_REQUIRES_(Tree::dimension() == nd
+                              and !std::is_same<Tree, frozen_tree>{})>
+  explicit frozen_tree(Tree const& t)
+   : frozen_tree(
+      serialization::succinct::encode(t, serialization::succinct::order::bfs)) {
+  }
+};
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,324 @@
+#pragma once
+/// \file linear_tree.hpp Linear nd-octree: sorted array of leaf locations
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <ndtree/concepts.hpp>
+#include <ndtree/location/slim.hpp>
+#include <ndtree/relations/dimension.hpp>
+#include <ndtree/relations/tree.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/math.hpp>
+#include <ndtree/utility/ranges.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Linear nd-octree: only the leaves are stored, as a sorted array of their
+/// location codes
+///
+/// \tparam nd Number of spatial dimensions
+/// \tparam UInt Unsigned integer type of the location codes
+///
+/// The leaves are sorted in Morton Z-Curve (depth-first) order, that is, by
+/// their location code aligned to the finest level. The leaves always cover
+/// the whole domain. Leaf indices are positions within the sorted array and
+/// are invalidated by refine and coarsen.
+///
+/// Memory requirements: 1 location code per leaf.
+template <int nd, typename UInt = uint_t> struct linear_tree {
+  using location_t = location::slim<nd, UInt>;
+  using integer_t = UInt;
+
+ private:
+  /// Sorted leaf locations
+  std::vector<location_t> leaves_;
+
+  /// Location code of \p l without its sentinel bit aligned to the finest
+  /// level (the Morton code of its first descendant at the finest level)
+  static integer_t key(location_t l) noexcept {
+    const uint_t lvl = l.level();
+    const integer_t code = l.value ^ (integer_t{1} << (nd * lvl));
+    return code << (nd * (location_t::max_level() - lvl));
+  }
+
+  /// Key of the last descendant of \p l at the finest level
+  static integer_t last_key(location_t l) noexcept {
+    const uint_t s = nd * (location_t::max_level() - l.level());
+    return key(l) | ((integer_t{1} << s) - 1);
+  }
+
+  /// Does the node \p a contain the node \p b (or is equal to it)?
+  static bool contains(location_t a, location_t b) noexcept {
+    const uint_t la = a.level();
+    const uint_t lb = b.level();
+    return la <= lb and (b.value >> (nd * (lb - la))) == a.value;
+  }
+
+  /// Position of the first leaf with key > \p k
+  auto upper_bound(integer_t k) const noexcept {
+    return std::upper_bound(
+     leaves_.begin(), leaves_.end(), k,
+     [](integer_t v, location_t const& l) { return v < key(l); });
+  }
+
+  /// Position of the first leaf with key >= \p k
+  auto lower_bound(integer_t k) const noexcept {
+    return std::lower_bound(
+     leaves_.begin(), leaves_.end(), k,
+     [](location_t const& l, integer_t v) { return key(l) < v; });
+  }
+
+  /// Appends the leaves of the subtree of \p t rooted at \p n with location
+  /// \p l in depth-first order
+  template <typename Tree>
+  void append_leaves(Tree const& t, node_idx n, location_t l) {
+    if (t.is_leaf(n)) {
+      leaves_.push_back(l);
+      return;
+    }
+    uint_t p = 0;
+    RANGES_FOR(auto&& c, t.children(n)) {
+      auto cl = l;
+      cl.push(p++);
+      append_leaves(t, c, cl);
+    }
+  }
+
+  /// Lower and upper (exclusive) corners of the node \p l in units of nodes
+  /// at the finest level
+  static std::array<std::array<integer_t, nd>, 2> bounds(location_t l) {
+    auto xs = static_cast<std::array<integer_t, nd>>(l);
+    const uint_t s = location_t::max_level() - l.level();
+    std::array<std::array<integer_t, nd>, 2> r;
+    for (auto&& d : dimensions(nd)) {
+      r[0][d] = xs[d] << s;
+      r[1][d] = r[0][d] + (integer_t{1} << s);
+    }
+    return r;
+  }
+
+  /// Is the node \p b adjacent to the node \p a across \p offset?
+  static bool adjacent(location_t a, location_t b,
+                       std::array<int_t, nd> offset) noexcept {
+    const auto ba = bounds(a);
+    const auto bb = bounds(b);
+    for (auto&& d : dimensions(nd)) {
+      if (offset[d] > 0 and bb[0][d] != ba[1][d]) { return false; }
+      if (offset[d] < 0 and bb[1][d] != ba[0][d]) { return false; }
+      if (offset[d] == 0 and (bb[1][d] <= ba[0][d] or bb[0][d] >= ba[1][d])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ public:
+  /// Number of spatial dimensions of the tree
+  static constexpr int_t dimension() noexcept { return nd; }
+
+  /// Number of children per node
+  static constexpr uint_t no_children() noexcept {
+    return ndtree::no_children(nd);
+  }
+
+  /// Number of leaves
+  uint_t size() const noexcept { return leaves_.size(); }
+
+  /// Sorted leaf locations
+  std::vector<location_t> const& leaves() const noexcept { return leaves_; }
+
+  /// Location of the leaf \p i
+  location_t const& operator[](node_idx i) const noexcept {
+    NDTREE_ASSERT(*i < size(), "leaf {} out-of-bounds [0, {})", *i, size());
+    return leaves_[*i];
+  }
+
+  /// Memory used by the leaves in bytes
+  uint_t memory_usage() const noexcept {
+    return leaves_.size() * sizeof(location_t);
+  }
+
+  /// Node containing the location \p loc
+  struct node {
+    /// Index of the leaf, invalid if the node is not a leaf
+    node_idx idx{};
+    /// Level of the node
+    uint_t level = 0_u;
+  };
+
+  /// Smallest node containing \p loc with level <= loc.level
+  ///
+  /// This is either the leaf containing \p loc, or, if there are leaves
+  /// below \p loc, the (internal) node at \p loc itself.
+  ///
+  /// Time complexity: O(log(N))
+  node node_or_parent_at(location_t loc) const noexcept {
+    auto it = upper_bound(key(loc));
+    NDTREE_ASSERT(it != leaves_.begin(), "leaves do not cover the domain");
+    --it;
+    if (contains(*it, loc)) {
+      return {node_idx{static_cast<uint_t>(it - leaves_.begin())},
+              it->level()};
+    }
+    return {node_idx{}, loc.level()};
+  }
+
+  /// Index of the leaf at location \p loc (invalid if there is no such leaf)
+  ///
+  /// Time complexity: O(log(N))
+  node_idx node_at(location_t loc) const noexcept {
+    const auto n = node_or_parent_at(loc);
+    return n.idx and leaves_[*n.idx] == loc ? n.idx : node_idx{};
+  }
+
+  /// Appends to \p s the leaves adjacent to the node \p loc across
+  /// \p offset (a vector with components in {-1, 0, 1})
+  ///
+  /// Time complexity: O(log(N) + M) where M is the number of leaves within
+  /// the node obtained by shifting \p loc by \p offset.
+  template <typename PushBackableContainer>
+  void neighbors(location_t loc, std::array<int_t, nd> offset,
+                 PushBackableContainer& s) const {
+    auto shifted = shift(loc, offset);
+    if (!shifted) { return; }
+    const auto n = node_or_parent_at(*shifted);
+    if (n.idx) {  // the shifted node is (within) a leaf
+      s.push_back(n.idx);
+      return;
+    }
+    // the shifted node is refined: search its leaves
+    const auto first = lower_bound(key(*shifted));
+    const auto last = upper_bound(last_key(*shifted));
+    for (auto it = first; it != last; ++it) {
+      if (adjacent(loc, *it, offset)) {
+        s.push_back(node_idx{static_cast<uint_t>(it - leaves_.begin())});
+      }
+    }
+  }
+
+  /// Leaves adjacent to the leaf \p i across all faces, edges, and corners
+  /// (sorted, without duplicates)
+  std::vector<node_idx> neighbors(node_idx i) const {
+    std::vector<node_idx> s;
+    std::array<int_t, nd> offset;
+    const uint_t no_offsets = math::ipow(3_u, static_cast<uint_t>(nd));
+    for (uint_t o = 0; o != no_offsets; ++o) {
+      uint_t v = o;
+      bool zero = true;
+      for (auto&& d : dimensions(nd)) {
+        offset[d] = static_cast<int_t>(v % 3) - 1;
+        zero = zero and offset[d] == 0;
+        v /= 3;
+      }
+      if (!zero) { neighbors((*this)[i], offset, s); }
+    }
+    std::sort(s.begin(), s.end(),
+              [](node_idx a, node_idx b) { return *a < *b; });
+    s.erase(std::unique(s.begin(), s.end()), s.end());
+    return s;
+  }
+
+  /// Refines the leaves of the range \p is
+  ///
+  /// The children are merged into the sorted leaf array in a single pass.
+  ///
+  /// \pre the leaves are not at the finest level
+  ///
+  /// Time complexity: O(N + M log(M)), where M is the number of refined
+  /// leaves.
+  template <typename Rng, CONCEPT_REQUIRES_(Range<Rng>{})>
+  void refine(Rng&& is) {
+    std::vector<uint_t> rs;
+    RANGES_FOR(auto&& i, is) { rs.push_back(*node_idx{i}); }
+    std::sort(rs.begin(), rs.end());
+    rs.erase(std::unique(rs.begin(), rs.end()), rs.end());
+
+    std::vector<location_t> leaves;
+    leaves.reserve(size() + rs.size() * (no_children() - 1));
+    auto r = rs.begin();
+    for (uint_t i = 0; i != size(); ++i) {
+      if (r == rs.end() or *r != i) {
+        leaves.push_back(leaves_[i]);
+        continue;
+      }
+      ++r;
+      for (uint_t p = 0; p != no_children(); ++p) {
+        auto c = leaves_[i];
+        c.push(p);
+        leaves.push_back(c);
+      }
+    }
+    leaves_ = std::move(leaves);
+  }
+
+  /// Refines the leaf \p i
+  void refine(node_idx i) { refine(std::array<node_idx, 1>{{i}}); }
+
+  /// Coarsens the nodes at the locations of the range \p ls: replaces all
+  /// leaves within each node by the node itself
+  ///
+  /// Nodes that are leaves or lie within other coarsened nodes are skipped.
+  ///
+  /// \pre the nodes are within the tree (they are leaves or have leaves
+  /// below them)
+  ///
+  /// Time complexity: O(N + M log(M)), where M is the number of nodes in
+  /// \p ls.
+  template <typename Rng, CONCEPT_REQUIRES_(Range<Rng>{})>
+  void coarsen(Rng&& ls) {
+    std::vector<location_t> cs;
+    RANGES_FOR(auto&& l, ls) { cs.push_back(l); }
+    // sort by key, parents before their descendants:
+    std::sort(cs.begin(), cs.end(), [](location_t a, location_t b) {
+      return key(a) < key(b) or (key(a) == key(b) and a.level() < b.level());
+    });
+
+    std::vector<location_t> leaves;
+    leaves.reserve(size());
+    auto c = cs.begin();
+    for (auto it = leaves_.begin(); it != leaves_.end();) {
+      // skip the nodes before the current leaf and the nested nodes:
+      while (c != cs.end() and last_key(*c) < key(*it)) { ++c; }
+      if (c == cs.end() or !contains(*c, *it)) {
+        leaves.push_back(*it++);
+        continue;
+      }
+      leaves.push_back(*c);
+      const auto last = last_key(*c);
+      while (it != leaves_.end() and key(*it) <= last) { ++it; }
+    }
+    leaves_ = std::move(leaves);
+  }
+
+  /// Coarsens the node at location \p l
+  void coarsen(location_t l) { coarsen(std::array<location_t, 1>{{l}}); }
+
+  /// Linear tree consisting of the root node only
+  linear_tree() : leaves_{location_t{}} {}
+
+  /// Linear tree with the leaves of the tree \p t
+  ///
+  /// Time complexity: O(N)
+  template <typename Tree, CONCEPT_REQUIRES_(Tree::dimension() == nd)>
+  explicit linear_tree(Tree const& t) {
+    append_leaves(t, 0_n, location_t{});
+  }
+};
+
+template <int nd, typename UInt>
+bool operator==(linear_tree<nd, UInt> const& a,
+                linear_tree<nd, UInt> const& b) noexcept {
+  return a.leaves() == b.leaves();
+}
+
+template <int nd, typename UInt>
+bool operator!=(linear_tree<nd, UInt> const& a,
+                linear_tree<nd, UInt> const& b) noexcept {
+  return !(a == b);
+}
+
+}  // namespace v1
+}  // namespace ndtree
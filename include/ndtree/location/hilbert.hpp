@@ -0,0 +1,217 @@
+#pragma once
+/// \file hilbert.hpp
+#include <cstdint>
+#include <ndtree/concepts.hpp>
+#include <ndtree/location/slim.hpp>
+#include <ndtree/relations/dimension.hpp>
+#include <ndtree/relations/tree.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/bit.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+namespace location {
+
+/// Location code ordered along a Hilbert curve
+///
+/// Positions in parent (push, pop, operator[], ...) are Morton positions in
+/// parent, as in every other location type, and the integer and coordinate
+/// conversions return the Morton code. Locations are ordered (operator<) by
+/// their Hilbert index instead, which is stored alongside the Morton code
+/// together with the orientation of the curve within the node.
+template <uint_t nd, typename UInt = uint_t>  //
+struct hilbert {
+  using this_t = hilbert<nd, UInt>;
+  using morton_t = slim<nd, UInt>;
+
+  using value_type = this_t;
+  using storage_type = this_t;
+  using reference_type = this_t const&;
+  using integer_t = UInt;
+
+  static_assert(UnsignedIntegral<integer_t>{},
+                "location::hilbert storage must be an unsigned integral type");
+  static_assert(nd <= 8, "location::hilbert supports up to 8 dimensions");
+
+  /// Hilbert index (with a leading sentinel bit, as in slim)
+  integer_t value = 1;  /// Default constructed to the root node
+  /// Morton code
+  morton_t morton;
+  /// Entry point of the curve within the node
+  std::uint8_t entry = 0;
+  /// Intra direction of the curve within the node
+  std::uint8_t direction = 0;
+
+  static constexpr uint_t dimension() noexcept { return nd; }
+  static auto dimensions() noexcept { return ndtree::dimensions(dimension()); }
+
+  static constexpr uint_t no_levels() noexcept { return morton_t::no_levels(); }
+  static constexpr uint_t max_level() noexcept { return no_levels() - 1; }
+
+  constexpr uint_t level() const noexcept { return morton.level(); }
+
+  /// Hilbert index of the location (with a leading sentinel bit)
+  constexpr integer_t hilbert_index() const noexcept { return value; }
+
+  void push(uint_t position_in_parent) noexcept {
+    NDTREE_ASSERT(position_in_parent < no_children(nd),
+                  "position in parent {} out-of-bounds [0, {}) (nd: {})",
+                  position_in_parent, no_children(nd), nd);
+    morton.push(position_in_parent);
+    const uint_t w
+     = bit::hilbert::digit(entry, direction, position_in_parent, nd);
+    value = (value << nd) + w;
+    entry = static_cast<std::uint8_t>(
+     bit::hilbert::child_entry_point(entry, direction, w, nd));
+    direction = static_cast<std::uint8_t>(
+     bit::hilbert::child_intra_direction(direction, w, nd));
+  }
+  template <typename Tag>
+  void push(bounded<uint_t, 0, no_children(nd), Tag> position_in_parent) {
+    push(*position_in_parent);
+  }
+  uint_t pop() noexcept {
+    NDTREE_ASSERT(level() > 0_u, "cannot pop root-node from location code");
+    const uint_t w = value & (no_children(nd) - 1);
+    value >>= nd;
+    direction = static_cast<std::uint8_t>(
+     bit::hilbert::parent_intra_direction(direction, w, nd));
+    entry = static_cast<std::uint8_t>(
+     bit::hilbert::parent_entry_point(entry, direction, w, nd));
+    return morton.pop();
+  }
+
+  bool valid() const noexcept { return value != 0; }
+
+  uint_t operator[](const uint_t level_) const noexcept {
+    return morton[level_];
+  }
+
+  auto levels() const noexcept { return morton.levels(); }
+
+  auto operator()() const noexcept { return morton(); }
+
+  hilbert() = default;
+  hilbert(hilbert const&) = default;
+  hilbert& operator=(hilbert const&) = default;
+  hilbert(hilbert&&) = default;
+  hilbert& operator=(hilbert&&) = default;
+
+  hilbert(std::initializer_list<uint_t> list) : hilbert() {
+    for (auto&& p : list) { push(p); }
+  }
+
+  /// Location of the Morton code \p m
+  explicit hilbert(morton_t m) : hilbert() {
+    RANGES_FOR(auto&& p, m()) { push(p); }
+  }
+
+  template <typename U, CONCEPT_REQUIRES_(std::is_floating_point<U>{})>
+  hilbert(std::array<U, nd> x_, uint_t l = (max_level() - 1))
+   : hilbert(morton_t(x_, l)) {}
+
+  // from root:
+  template <class Rng, CONCEPT_REQUIRES_(Range<Rng>())>
+  hilbert(Rng&& ps) : hilbert() {
+    for (auto&& p : ps) { push(p); }
+  }
+
+  void reverse() {
+    hilbert other;
+    for (auto l : (*this)() | view::reverse) { other.push(l); }
+    (*this) = other;
+  }
+
+  explicit operator integer_t() const noexcept {
+    return static_cast<integer_t>(morton);
+  }
+
+  explicit operator std::array<integer_t, nd>() const noexcept {
+    return static_cast<std::array<integer_t, nd>>(morton);
+  }
+
+  static constexpr this_t empty_value() noexcept {
+    this_t t;
+    t.value = integer_t{0};
+    return t;
+  }
+  static constexpr bool is_empty_value(this_t v) noexcept {
+    return v.value == integer_t{0};
+  }
+
+  static constexpr value_type const& access_value(
+   storage_type const& v) noexcept {
+    return v;
+  }
+  static constexpr value_type const& store_value(value_type const& v) noexcept {
+    return v;
+  }
+  static constexpr value_type&& store_value(value_type&& v) noexcept {
+    return std::move(v);
+  }
+};
+
+template <typename OStream, uint_t nd, typename T>
+OStream& operator<<(OStream& os, hilbert<nd, T> const& lc) {
+  os << "[hilbert: " << lc.hilbert_index() << ", morton: " << lc.morton
+     << "]";
+  return os;
+}
+
+template <uint_t nd, typename T>
+compact_optional<hilbert<nd, T>> shift(hilbert<nd, T> t,
+                                       std::array<int_t, nd> offset) noexcept {
+  auto m = shift(t.morton, offset);
+  if (!m) { return compact_optional<hilbert<nd, T>>{}; }
+  return compact_optional<hilbert<nd, T>>{hilbert<nd, T>(*m)};
+}
+
+template <uint_t nd, class T>
+constexpr bool operator==(hilbert<nd, T> const& a,
+                          hilbert<nd, T> const& b) noexcept {
+  return a.value == b.value;
+}
+
+template <uint_t nd, class T>
+constexpr bool operator!=(hilbert<nd, T> const& a,
+                          hilbert<nd, T> const& b) noexcept {
+  return !(a == b);
+}
+
+template <uint_t nd, class T>
+constexpr bool operator<(hilbert<nd, T> const& a,
+                         hilbert<nd, T> const& b) noexcept {
+  return a.value < b.value;
+}
+
+template <uint_t nd, class T>
+constexpr bool operator<=(hilbert<nd, T> const& a,
+                          hilbert<nd, T> const& b) noexcept {
+  return (a == b) or (a < b);
+}
+
+template <uint_t nd, class T>
+constexpr bool operator>(hilbert<nd, T> const& a,
+                         hilbert<nd, T> const& b) noexcept {
+  return !(a <= b);
+}
+
+template <uint_t nd, class T>
+constexpr bool operator>=(hilbert<nd, T> const& a,
+                          hilbert<nd, T> const& b) noexcept {
+  return !(a < b);
+}
+
+static_assert(std::is_standard_layout<hilbert<1_u>>{}, "");
+static_assert(std::is_literal_type<hilbert<1_u>>{}, "");
+static_assert(std::is_nothrow_default_constructible<hilbert<1_u>>{}, "");
+static_assert(std::is_nothrow_copy_constructible<hilbert<1_u>>{}, "");
+static_assert(std::is_nothrow_move_constructible<hilbert<1_u>>{}, "");
+static_assert(std::is_nothrow_copy_assignable<hilbert<1_u>>{}, "");
+static_assert(std::is_nothrow_move_assignable<hilbert<1_u>>{}, "");
+static_assert(std::is_trivially_destructible<hilbert<1_u>>{}, "");
+
+}  // namespace location
+}  // namespace v1
+}  // namespace ndtree
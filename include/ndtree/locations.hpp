@@ -1,5 +1,6 @@
 #pragma once
 /// \file locations.hpp
 #include <ndtree/location/fast.hpp>
+#include <ndtree/location/hilbert.hpp>
 #include <ndtree/location/slim.hpp>
 #include <ndtree/location/default.hpp>
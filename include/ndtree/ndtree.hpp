@@ -1,9 +1,14 @@
 #pragma once
 /// \file ndtree.hpp Includes all headers
 #include <ndtree/algorithm.hpp>
+#include <ndtree/concurrent_refinement.hpp>
+#include <ndtree/concurrent_tree.hpp>
+#include <ndtree/epoch_tree.hpp>
+#include <ndtree/frozen_tree.hpp>
 #include <ndtree/locations.hpp>
 #include <ndtree/types.hpp>
 #include <ndtree/tree.hpp>
+#include <ndtree/versioned_tree.hpp>
 
 /// nd-octree
 namespace ndtree {
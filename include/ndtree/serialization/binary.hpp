@@ -0,0 +1,226 @@
+#pragma once
+/// \file binary.hpp Binary checkpoint/restart format for trees and node data
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <ndtree/tree.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/optional.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+namespace serialization {
+
+/// Binary checkpoint format
+///
+/// File layout:
+/// - header (see header),
+/// - parent of each stored sibling group (header::no_sibling_groups indices),
+/// - first child of each stored node (no_nodes(no_sibling_groups) indices),
+/// - header::no_payloads payload records, each one consisting of its element
+///   size and number of elements (2 x uint64_t) followed by one element per
+///   stored node.
+///
+/// Compact trees are stored in compacted form: only the sibling groups in use
+/// are written. Otherwise the whole index arrays, including the free sibling
+/// groups, are written, so that node indices remain valid.
+///
+/// All data is written in native byte order. The arrays are read and written
+/// with one call each, and are protected by a checksum.
+namespace binary {
+
+/// Current version of the format
+constexpr std::uint32_t version() noexcept { return 1; }
+
+/// Identifies checkpoint files
+constexpr char magic[8] = {'n', 'd', 't', 'r', 'e', 'e', 'c', 'k'};
+
+/// Detects files written with a different byte order
+constexpr std::uint32_t byte_order_mark() noexcept { return 0x01020304; }
+
+/// File header
+struct header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order_mark;
+  std::uint32_t dimension;
+  std::uint32_t index_size;
+  /// Number of stored sibling groups
+  std::uint64_t no_sibling_groups;
+  /// Number of payload records
+  std::uint64_t no_payloads;
+  /// Checksum of the header (with checksum == 0) and of all data after it
+  std::uint64_t checksum;
+};
+
+/// Incremental 64-bit checksum (word-wise multiply-rotate hash)
+struct checksum {
+  std::uint64_t value = 0x9E3779B97F4A7C15ull;
+
+  /// Adds \p bytes bytes starting at \p data
+  void update(void const* data, std::uint64_t bytes) noexcept {
+    auto p = static_cast<unsigned char const*>(data);
+    std::uint64_t w;
+    for (; bytes >= 8; p += 8, bytes -= 8) {
+      std::memcpy(&w, p, 8);
+      mix(w);
+    }
+    w = 0;
+    std::memcpy(&w, p, bytes);
+    mix(w ^ (bytes << 56));
+  }
+
+ private:
+  void mix(std::uint64_t w) noexcept {
+    value = (value ^ w) * 0xFF51AFD7ED558CCDull;
+    value = (value << 31) | (value >> 33);
+  }
+};
+
+/// Number of sibling groups stored for the tree \p t
+template <typename Tree> uint_t no_stored_sibling_groups(Tree const& t) {
+  return t.is_compact() ? *t.sibling_group(t.size())
+                        : *t.sibling_group_capacity();
+}
+
+/// Writes the tree \p t and the node data arrays \p payloads to the file
+/// \p path
+///
+/// \param t [in] Tree.
+/// \param payloads [in] Node data arrays (e.g. std::vector<T>) of trivially
+///                      copyable elements, indexed by node (one array per
+///                      data member for a Struct of Arrays layout). Only the
+///                      elements of the stored nodes are written.
+///
+/// \pre !t.empty()
+/// \pre size(p) >= t.capacity() (or t.size() if t.is_compact()) for all
+/// payloads p
+///
+/// \returns true on success
+///
+/// Time complexity: O(N)
+template <typename Tree, typename... Payloads>
+bool write(std::string const& path, Tree const& t,
+           Payloads const&... payloads) {
+  using index_t = typename Tree::index_t;
+  NDTREE_ASSERT(!t.empty(), "cannot write an empty tree");
+
+  header h;
+  std::memcpy(h.magic, magic, sizeof(magic));
+  h.version = version();
+  h.byte_order_mark = byte_order_mark();
+  h.dimension = Tree::dimension();
+  h.index_size = sizeof(index_t);
+  h.no_sibling_groups = no_stored_sibling_groups(t);
+  h.no_payloads = sizeof...(Payloads);
+  h.checksum = 0;
+  const std::uint64_t no_nodes
+   = *Tree::no_nodes(siblings_idx{static_cast<uint_t>(h.no_sibling_groups)});
+
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) { return false; }
+  checksum c;
+  c.update(&h, sizeof(header));
+  bool ok = std::fwrite(&h, sizeof(header), 1, f) == 1;
+  auto write_array = [&](void const* data, std::uint64_t bytes) {
+    c.update(data, bytes);
+    ok = ok and std::fwrite(data, 1, bytes, f) == bytes;
+  };
+  write_array(t.raw_parents(), h.no_sibling_groups * sizeof(index_t));
+  write_array(t.raw_first_children(), no_nodes * sizeof(index_t));
+  auto write_payload = [&](auto const& p) {
+    using T = std::decay_t<decltype(*p.data())>;
+    static_assert(std::is_trivially_copyable<T>{},
+                  "payload elements must be trivially copyable");
+    NDTREE_ASSERT(p.size() >= no_nodes, "payload of size {} < {} nodes",
+                  p.size(), no_nodes);
+    const std::uint64_t record[2] = {sizeof(T), no_nodes};
+    write_array(record, sizeof(record));
+    write_array(p.data(), no_nodes * sizeof(T));
+    return 0;
+  };
+  const int expand[] = {0, write_payload(payloads)...};
+  (void)expand;
+
+  // write the checksum into the header:
+  h.checksum = c.value;
+  ok = ok and std::fseek(f, 0, SEEK_SET) == 0
+       and std::fwrite(&h, sizeof(header), 1, f) == 1;
+  return std::fclose(f) == 0 and ok;
+}
+
+/// Reads a tree of type Tree and its node data arrays \p payloads from the
+/// file \p path
+///
+/// \param payloads [out] Node data arrays (std::vector<T>), which are resized
+///                       to the number of stored nodes. Their number and
+///                       element types must match those written.
+///
+/// \returns an empty optional if the file cannot be read, its version, byte
+/// order, dimension, index width or payloads do not match, or its checksum
+/// is invalid (the payloads are then in an unspecified state)
+///
+/// Time complexity: O(N)
+template <typename Tree, typename... Ts>
+optional<Tree> read(std::string const& path, std::vector<Ts>&... payloads) {
+  using index_t = typename Tree::index_t;
+  using storage_t = typename Tree::storage_t;
+
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if (!f) { return {}; }
+  header h;
+  bool ok = std::fread(&h, sizeof(header), 1, f) == 1
+            and std::memcmp(h.magic, magic, sizeof(magic)) == 0
+            and h.version == version()
+            and h.byte_order_mark == byte_order_mark()
+            and h.dimension == static_cast<std::uint32_t>(Tree::dimension())
+            and h.index_size == sizeof(index_t) and h.no_sibling_groups > 0
+            and h.no_sibling_groups <= *Tree::max_sibling_group_capacity()
+            and h.no_payloads == sizeof...(Ts);
+  if (!ok) {
+    std::fclose(f);
+    return {};
+  }
+
+  checksum c;
+  const auto expected_checksum = h.checksum;
+  h.checksum = 0;
+  c.update(&h, sizeof(header));
+  auto read_array = [&](void* data, std::uint64_t bytes) {
+    ok = ok and std::fread(data, 1, bytes, f) == bytes;
+    if (ok) { c.update(data, bytes); }
+  };
+
+  const auto no_sgs = siblings_idx{static_cast<uint_t>(h.no_sibling_groups)};
+  const uint_t no_nodes = *Tree::no_nodes(no_sgs);
+  auto parents = storage_t::template allocate<index_t>(*no_sgs);
+  auto first_children = storage_t::template allocate<index_t>(no_nodes);
+  read_array(parents.get(), *no_sgs * sizeof(index_t));
+  read_array(first_children.get(), no_nodes * sizeof(index_t));
+  auto read_payload = [&](auto& p) {
+    using T = typename std::decay_t<decltype(p)>::value_type;
+    static_assert(std::is_trivially_copyable<T>{},
+                  "payload elements must be trivially copyable");
+    std::uint64_t record[2] = {0, 0};
+    read_array(record, sizeof(record));
+    ok = ok and record[0] == sizeof(T) and record[1] == no_nodes;
+    if (!ok) { return 0; }
+    p.resize(no_nodes);
+    read_array(p.data(), no_nodes * sizeof(T));
+    return 0;
+  };
+  const int expand[] = {0, read_payload(payloads)...};
+  (void)expand;
+  std::fclose(f);
+
+  if (!ok or c.value != expected_checksum) { return {}; }
+  return Tree(no_sgs, std::move(parents), std::move(first_children));
+}
+
+}  // namespace binary
+}  // namespace serialization
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,170 @@
+#pragma once
+/// \file mmap.hpp Saves trees to files that can be memory mapped (POSIX)
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <ndtree/storage/mmap.hpp>
+#include <ndtree/tree.hpp>
+#include <ndtree/utility/optional.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+namespace serialization {
+
+/// Memory mappable tree files
+///
+/// File layout:
+/// - header (see header),
+/// - parents of each sibling group at byte header::parents_offset,
+/// - first children of each node at byte header::first_children_offset,
+///
+/// where both offsets are multiples of alignment(), so that the index arrays
+/// can be mapped directly from the file.
+namespace mmap {
+
+/// Alignment of the index arrays within the file (a multiple of the page
+/// size of the supported platforms)
+constexpr std::uint64_t alignment() noexcept { return 65536; }
+
+/// File header
+struct header {
+  char magic[8];
+  std::uint64_t dimension;
+  std::uint64_t index_size;
+  std::uint64_t sibling_group_capacity;
+  std::uint64_t parents_offset;
+  std::uint64_t first_children_offset;
+};
+
+/// Identifies tree files
+constexpr char magic[8] = {'n', 'd', 't', 'r', 'e', 'e', 'm', '1'};
+
+/// Smallest multiple of alignment() that is >= \p n
+constexpr std::uint64_t align(std::uint64_t n) noexcept {
+  return (n + alignment() - 1) / alignment() * alignment();
+}
+
+/// Is [\p offset, \p offset + \p bytes) an aligned region of a file of
+/// \p file_size bytes that starts after the header?
+constexpr bool valid_region(std::uint64_t offset, std::uint64_t bytes,
+                            std::uint64_t file_size) noexcept {
+  return offset % alignment() == 0 and offset >= sizeof(header)
+         and offset <= file_size and bytes <= file_size - offset;
+}
+
+/// Do the regions [\p a, \p a + \p a_bytes) and [\p b, \p b + \p b_bytes)
+/// overlap?
+///
+/// \pre both regions are valid (see valid_region)
+constexpr bool overlap(std::uint64_t a, std::uint64_t a_bytes,
+                       std::uint64_t b, std::uint64_t b_bytes) noexcept {
+  return a < b + b_bytes and b < a + a_bytes;
+}
+
+/// Header of the tree \p t
+template <typename Tree> header make_header(Tree const& t) noexcept {
+  using index_t = typename Tree::index_t;
+  header h;
+  std::memcpy(h.magic, magic, sizeof(magic));
+  h.dimension = Tree::dimension();
+  h.index_size = sizeof(index_t);
+  h.sibling_group_capacity = *t.sibling_group_capacity();
+  h.parents_offset = align(sizeof(header));
+  h.first_children_offset
+   = align(h.parents_offset + h.sibling_group_capacity * sizeof(index_t));
+  return h;
+}
+
+/// Saves the tree \p t to the file \p path
+///
+/// The tree can be opened later without rebuilding it (see open).
+///
+/// \returns true on success
+///
+/// Time complexity: O(N)
+template <typename Tree> bool save(Tree const& t, std::string const& path) {
+  using index_t = typename Tree::index_t;
+  const auto h = make_header(t);
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) { return false; }
+  auto write_at = [&](std::uint64_t offset, void const* data,
+                      std::uint64_t bytes) {
+    return std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0
+           and std::fwrite(data, 1, bytes, f) == bytes;
+  };
+  const bool ok
+   = write_at(0, &h, sizeof(header))
+     and write_at(h.parents_offset, t.raw_parents(),
+                  *t.sibling_group_capacity() * sizeof(index_t))
+     and write_at(h.first_children_offset, t.raw_first_children(),
+                  *t.capacity() * sizeof(index_t));
+  return std::fclose(f) == 0 and ok;
+}
+
+/// Opens the tree stored in the file \p path by memory mapping its indices
+///
+/// The indices are paged in on demand. The returned tree can be modified:
+/// the file mapping is private, so modifications are never written back to
+/// the file (use save for that).
+///
+/// \returns an empty optional if the file cannot be opened or does not
+/// contain a tree of type Tree (including if the index arrays of its header
+/// are misaligned, overlap, or do not fit within the file)
+///
+/// Time complexity: O(G), where G is the sibling group capacity (only the
+/// parents are read).
+template <typename Tree> optional<Tree> open(std::string const& path) {
+  using index_t = typename Tree::index_t;
+  static_assert(std::is_same<typename Tree::storage_t, mmap_storage>{},
+                "trees opened from a file must use mmap_storage");
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) { return {}; }
+  struct stat st;
+  header h;
+  const bool valid_header
+   = ::fstat(fd, &st) == 0
+     and ::pread(fd, &h, sizeof(header), 0)
+          == static_cast<ssize_t>(sizeof(header))
+     and std::memcmp(h.magic, magic, sizeof(magic)) == 0
+     and h.dimension == static_cast<std::uint64_t>(Tree::dimension())
+     and h.index_size == sizeof(index_t) and h.sibling_group_capacity > 0
+     and h.sibling_group_capacity <= *Tree::max_sibling_group_capacity();
+  if (!valid_header) {
+    ::close(fd);
+    return {};
+  }
+
+  const uint_t sg_capacity = h.sibling_group_capacity;
+  const uint_t capacity = *Tree::no_nodes(siblings_idx{sg_capacity});
+  // the capacities are bounded by the index type, so these do not overflow:
+  const std::uint64_t parents_bytes = sg_capacity * sizeof(index_t);
+  const std::uint64_t first_children_bytes = capacity * sizeof(index_t);
+  const auto file_size = static_cast<std::uint64_t>(st.st_size);
+  const bool valid_layout
+   = valid_region(h.parents_offset, parents_bytes, file_size)
+     and valid_region(h.first_children_offset, first_children_bytes,
+                      file_size)
+     and !overlap(h.parents_offset, parents_bytes, h.first_children_offset,
+                  first_children_bytes);
+  if (!valid_layout) {
+    ::close(fd);
+    return {};
+  }
+  mapped_array<index_t> parents(fd, h.parents_offset, sg_capacity);
+  mapped_array<index_t> first_children(fd, h.first_children_offset, capacity);
+  ::close(fd);  // the mappings remain valid
+  if (!parents or !first_children) { return {}; }
+
+  return Tree(siblings_idx{sg_capacity}, std::move(parents),
+              std::move(first_children));
+}
+
+}  // namespace mmap
+}  // namespace serialization
+}  // namespace v1
+}  // namespace ndtree
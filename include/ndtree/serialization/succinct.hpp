@@ -0,0 +1,130 @@
+#pragma once
+/// \file succinct.hpp Succinct tree encoding: one bit per node
+#include <cstdint>
+#include <vector>
+#include <ndtree/tree.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/bit.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+namespace serialization {
+
+/// Succinct tree encoding
+///
+/// A tree is encoded as one "refined?" bit per node, with the nodes visited
+/// in depth-first (pre-order) or breadth-first (level) order, and the
+/// children of a node visited in Morton Z-Curve order. This suffices to
+/// rebuild the tree graph, but not its memory layout: decoded trees are
+/// sorted in the order of the encoding (see dfs_sort and bfs_sort).
+namespace succinct {
+
+/// Node traversal order of an encoding
+enum class order { dfs, bfs };
+
+/// Succinctly encoded tree
+struct encoding {
+  /// Node traversal order
+  order traversal = order::dfs;
+  /// Number of bits (equal to the number of nodes)
+  uint_t size = 0;
+  /// Bits: bit i of the encoding is bit i % 64 of words[i / 64]
+  std::vector<std::uint64_t> words;
+
+  /// Was the i-th node of the traversal refined?
+  bool operator[](uint_t i) const noexcept {
+    NDTREE_ASSERT(i < size, "bit {} out of bounds [0, {})", i, size);
+    return (words[i / 64] >> (i % 64)) & 1;
+  }
+
+  /// Appends the bit \p refined
+  void push_back(bool refined) {
+    if (size % 64 == 0) { words.push_back(0); }
+    words.back() |= std::uint64_t{refined} << (size % 64);
+    ++size;
+  }
+};
+
+/// Encodes the tree \p t visiting its nodes in order \p o
+///
+/// \pre !t.empty()
+///
+/// Time complexity: O(N)
+/// Space complexity: O(N) bits (plus O(N) indices for BFS, O(L 2^nd) indices
+/// for DFS, where L is the maximum node level).
+template <typename Tree> encoding encode(Tree const& t, order o = order::dfs) {
+  NDTREE_ASSERT(!t.empty(), "cannot encode an empty tree");
+  encoding e;
+  e.traversal = o;
+  e.words.reserve((*t.size() + 63) / 64);
+  // nodes not yet visited: a stack for dfs, a queue for bfs
+  std::vector<node_idx> ns{0_n};
+  uint_t head = 0;
+  while (head != ns.size()) {
+    node_idx n;
+    if (o == order::dfs) {
+      n = ns.back();
+      ns.pop_back();
+    } else {
+      n = ns[head++];
+    }
+    const bool refined = !t.is_leaf(n);
+    e.push_back(refined);
+    if (!refined) { continue; }
+    for (uint_t i = 0; i != Tree::no_children(); ++i) {
+      // dfs: push in reverse order so that the first child is visited first
+      const uint_t p = o == order::dfs ? Tree::no_children() - 1 - i : i;
+      ns.push_back(t.child(n, child_pos<Tree>{p}));
+    }
+  }
+  NDTREE_ASSERT(e.size == *t.size(), "encoded {} nodes but the tree has {}",
+                e.size, *t.size());
+  return e;
+}
+
+/// Decodes the tree encoded in \p e
+///
+/// The children groups are allocated in the order of the encoding, so the
+/// decoded tree is compact and sorted in depth-first or breadth-first order.
+///
+/// \pre \p e is a valid encoding of a tree of type Tree
+///
+/// Time complexity: O(N)
+template <typename Tree> Tree decode(encoding const& e) {
+  NDTREE_ASSERT(e.size > 0, "cannot decode an empty encoding");
+  uint_t no_refined = 0;
+  for (auto&& w : e.words) { no_refined += bit::popcount(w); }
+  const uint_t no_nodes = 1 + no_refined * Tree::no_children();
+  NDTREE_ASSERT(no_nodes == e.size, "invalid encoding: {} bits, {} refined",
+                e.size, no_refined);
+
+  Tree t(no_nodes);
+  std::vector<node_idx> ns{0_n};
+  uint_t head = 0;
+  uint_t i = 0;
+  while (head != ns.size()) {
+    node_idx n;
+    if (e.traversal == order::dfs) {
+      n = ns.back();
+      ns.pop_back();
+    } else {
+      n = ns[head++];
+    }
+    NDTREE_ASSERT(i < e.size, "invalid encoding: more than {} nodes", e.size);
+    if (!e[i++]) { continue; }
+    t.refine(n);
+    for (uint_t j = 0; j != Tree::no_children(); ++j) {
+      const uint_t p
+       = e.traversal == order::dfs ? Tree::no_children() - 1 - j : j;
+      ns.push_back(t.child(n, child_pos<Tree>{p}));
+    }
+  }
+  NDTREE_ASSERT(i == e.size, "invalid encoding: decoded {} of {} nodes", i,
+                e.size);
+  return t;
+}
+
+}  // namespace succinct
+}  // namespace serialization
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,25 @@
+#pragma once
+/// \file heap.hpp Heap storage policy
+#include <memory>
+#include <ndtree/types.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Tree storage policy: arrays are allocated on the heap (default)
+///
+/// A storage policy provides:
+/// - `array<T>`: movable owning array type with `get()` and `operator[]`,
+/// - `allocate<T>(n)`: allocates an array of \p n elements.
+struct heap_storage {
+  template <typename T> using array = std::unique_ptr<T[]>;
+
+  /// Allocates an array of \p n elements
+  template <typename T> static array<T> allocate(uint_t n) {
+    return std::make_unique<T[]>(n);
+  }
+};
+
+}  // namespace v1
+}  // namespace ndtree
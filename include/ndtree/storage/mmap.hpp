@@ -0,0 +1,98 @@
+#pragma once
+/// \file mmap.hpp Memory-mapped storage policy (POSIX)
+#include <cstddef>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/terminate.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Owning array of trivially copyable elements backed by a memory mapping
+///
+/// The mapping is either anonymous (zero initialized memory), or a private
+/// (copy-on-write) mapping of a region of a file: the pages of the file are
+/// loaded on demand and modifications are never written back to the file.
+template <typename T> struct mapped_array {
+  static_assert(std::is_trivially_copyable<T>{},
+                "mapped_array elements must be trivially copyable");
+
+  mapped_array() = default;
+
+  /// Anonymous mapping of \p n zero initialized elements
+  explicit mapped_array(uint_t n) noexcept : mapped_array(-1, 0, n) {}
+
+  /// Private mapping of \p n elements of the file \p fd starting at byte
+  /// \p offset (a multiple of the page size); use -1 for an anonymous
+  /// mapping
+  ///
+  /// \post !(*this) if the mapping failed
+  mapped_array(int fd, std::size_t offset, uint_t n) noexcept {
+    if (n == 0) { return; }
+    const std::size_t bytes = n * sizeof(T);
+    const int flags = fd == -1 ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_PRIVATE;
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, fd,
+                     static_cast<off_t>(offset));
+    if (p == MAP_FAILED) { return; }
+    data_ = static_cast<T*>(p);
+    bytes_ = bytes;
+  }
+
+  mapped_array(mapped_array&& other) noexcept
+   : data_(other.data_), bytes_(other.bytes_) {
+    other.data_ = nullptr;
+    other.bytes_ = 0;
+  }
+  mapped_array& operator=(mapped_array&& other) noexcept {
+    if (this != &other) {
+      release();
+      data_ = other.data_;
+      bytes_ = other.bytes_;
+      other.data_ = nullptr;
+      other.bytes_ = 0;
+    }
+    return *this;
+  }
+  mapped_array(mapped_array const&) = delete;
+  mapped_array& operator=(mapped_array const&) = delete;
+  ~mapped_array() { release(); }
+
+  T* get() const noexcept { return data_; }
+  T& operator[](uint_t i) const noexcept { return data_[i]; }
+  explicit operator bool() const noexcept { return data_ != nullptr; }
+
+ private:
+  void release() noexcept {
+    if (data_) { ::munmap(data_, bytes_); }
+    data_ = nullptr;
+    bytes_ = 0;
+  }
+
+  T* data_ = nullptr;
+  std::size_t bytes_ = 0;
+};
+
+/// Tree storage policy: arrays are memory mappings
+///
+/// Trees opened from a file (see serialization::mmap::open) map their
+/// indices directly from the file. Arrays allocated afterwards (e.g. when the
+/// tree grows) are anonymous mappings.
+struct mmap_storage {
+  template <typename T> using array = mapped_array<T>;
+
+  /// Allocates an array of \p n elements
+  template <typename T> static array<T> allocate(uint_t n) noexcept {
+    array<T> r(n);
+    if (n != 0 and !r) {
+      NDTREE_TERMINATE("failed to map {} bytes of memory", n * sizeof(T));
+    }
+    return r;
+  }
+};
+
+}  // namespace v1
+}  // namespace ndtree
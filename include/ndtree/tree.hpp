@@ -3,21 +3,59 @@
 /// TODO:
 /// - replace int static casts with something better
 ///
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
 #include <ndtree/types.hpp>
+#include <ndtree/location/slim.hpp>
+#include <ndtree/storage/heap.hpp>
 #include <ndtree/relations/tree.hpp>
 #include <ndtree/utility/assert.hpp>
 #include <ndtree/utility/fmt.hpp>
 #include <ndtree/utility/math.hpp>
 #include <ndtree/utility/ranges.hpp>
 #include <ndtree/utility/bounded.hpp>
+#include <ndtree/utility/hierarchical_bitset.hpp>
+#include <ndtree/utility/open_hash_map.hpp>
+#include <ndtree/utility/parallel_for.hpp>
 
 namespace ndtree {
 inline namespace v1 {
 //
 
 /// nd-octree data-structure
-template <int nd> struct tree {
+///
+/// \tparam nd Number of spatial dimensions
+/// \tparam Index Unsigned integer type used to store node and sibling group
+///               indices in memory (e.g. uint16_t for small trees, uint32_t
+///               for trees with less than 2^32 - 1 nodes)
+/// \tparam Storage Storage policy of the node and sibling group indices
+///                 (heap_storage, mmap_storage)
+///
+template <int nd, typename Index, typename Storage> struct tree {
+  static_assert(UnsignedIntegral<Index>{},
+                "the tree index storage must be an unsigned integral type");
+
+  /// Type used to store node and sibling group indices in memory
+  using index_t = Index;
+  /// Storage policy of the node and sibling group indices
+  using storage_t = Storage;
+  /// Array of indices
+  using indices_t = typename Storage::template array<index_t>;
+  /// Type of the cached node locations
+  using location_t = ndtree::location::slim<nd>;
+
+  /// Synchronize the allocation and the linking of sibling groups
+  template <int, typename> friend struct concurrent_tree;
+  template <typename> friend struct concurrent_refinement;
+  template <int, typename> friend struct epoch_tree;
+  /// Copy the indices into copy-on-write arrays
+  template <int, typename> friend struct versioned_tree;
+
  private:
   /// \name Data (all member variables of the tree)
   ///
@@ -26,10 +64,15 @@ template <int nd> struct tree {
   ///
   /// The order of groups of children is arbitrary.
   ///
-  /// Memory requirements: 1 word + 1 / no_children word per node
+  /// Memory requirements: 1 + 1 / no_children index_t per node
   /// - each node stores the index of its first child (the other children are
   ///   stored contiguously after the first in Z-Order)
   /// - each group of siblings stores the index of its parent
+  /// - each group of siblings uses ~1 bit to track whether it is free
+  /// - optionally, each group of siblings stores its level (1 byte)
+  /// - optionally, each group of siblings stores its location (1 location_t)
+  /// - optionally, a hash map from node locations to node indices (2-4
+  ///   location_t and index_t pairs per node)
   ///
   ///@{
 
@@ -37,16 +80,59 @@ template <int nd> struct tree {
   /// store
   siblings_idx sg_capacity_ = 0_sg;
   /// Indices to the parent node of each sibling group (1 index / sibling group)
-  std::unique_ptr<node_idx[]> parents_ = nullptr;
+  indices_t parents_;
   /// Indices of the first children of each node (1 index / node)
-  std::unique_ptr<node_idx[]> first_children_ = nullptr;
+  indices_t first_children_;
   /// Number of nodes in the tree
   node_idx size_ = 0_n;
   /// First group of siblings that is free (i.e. not in use)
   siblings_idx first_free_sibling_group_{0};
+  /// Free sibling groups (bit set if the sibling group is free)
+  hierarchical_bitset free_sibling_groups_;
+  /// Level of each sibling group (optional, 1 byte / sibling group)
+  std::unique_ptr<std::uint8_t[]> levels_ = nullptr;
+  /// Location of the first node of each sibling group (optional, 1 location /
+  /// sibling group)
+  std::unique_ptr<location_t[]> locations_ = nullptr;
+  /// Index of the node at each location (optional, requires the location
+  /// cache)
+  using location_index_t
+   = open_hash_map<typename location_t::integer_t, index_t>;
+  std::unique_ptr<location_index_t> location_index_ = nullptr;
+  /// Hash of the subtrees of the nodes of each sibling group (optional, 1
+  /// word / sibling group)
+  std::unique_ptr<std::uint64_t[]> hashes_ = nullptr;
 
   ///@}  // Data
 
+  /// \name Index storage
+  ///@{
+
+  /// Value of an invalid index in memory
+  static constexpr index_t invalid_index() noexcept {
+    return std::numeric_limits<index_t>::max();
+  }
+
+  /// Loads a node index from its in memory representation \p i
+  static constexpr node_idx load(index_t i) noexcept {
+    return i == invalid_index() ? node_idx{}
+                                : node_idx{static_cast<uint_t>(i)};
+  }
+
+  /// In memory representation of node index \p n
+  static constexpr index_t store(node_idx n) noexcept {
+    return n ? static_cast<index_t>(*n) : invalid_index();
+  }
+
+  /// Allocates an array of \p n invalid indices
+  static indices_t make_indices(uint_t n) {
+    auto r = Storage::template allocate<index_t>(n);
+    std::fill(r.get(), r.get() + n, invalid_index());
+    return r;
+  }
+
+  ///@}  // Index storage
+
  public:
   /// \name Spatial constants
   ///@{
@@ -83,8 +169,7 @@ template <int nd> struct tree {
   /// Index of the sibling group of node \p n
   static constexpr siblings_idx sibling_group(node_idx n) noexcept {
     NDTREE_ASSERT(n, "cannot compute sibling group of invalid node");
-    return siblings_idx{static_cast<int_t>(
-     math::floor((*n + no_children() - 1.f) / no_children()))};
+    return siblings_idx{*n == 0 ? 0 : (*n - 1) / no_children() + 1};
   }
 
   /// Index of the parent node of the sibling group \p s
@@ -93,7 +178,7 @@ template <int nd> struct tree {
     NDTREE_ASSERT(s >= 0_sg and s < sibling_group_capacity(),
                   "sg {} is out-of-bounds for parents [{}, {})", s, 0,
                   sibling_group_capacity());
-    return parents_[*s];
+    return load(parents_[*s]);
   }
 
  private:
@@ -107,7 +192,7 @@ template <int nd> struct tree {
     NDTREE_ASSERT(s >= 0_sg and s < sibling_group_capacity(),
                   "sg {} is out-of-bounds for parents [{}, {})", s, 0,
                   sibling_group_capacity());
-    parents_[*s] = value;
+    parents_[*s] = store(value);
     NDTREE_ASSERT(parent(s) == value, "");
   }
 
@@ -131,7 +216,7 @@ template <int nd> struct tree {
     NDTREE_ASSERT(n >= 0_n and n < capacity(),
                   "node {} is out-of-bounds for first_child [{}, {})", n, 0,
                   capacity());
-    return first_children_[*n];
+    return load(first_children_[*n]);
     // cannot assert post-condition because swap temporarily violates it
   }
 
@@ -150,7 +235,7 @@ template <int nd> struct tree {
     NDTREE_ASSERT(n >= 0_n and n < capacity(),
                   "node {} is out-of-bounds for first_child [{}, {})", n, 0,
                   capacity());
-    first_children_[*n] = value;
+    first_children_[*n] = store(value);
     NDTREE_ASSERT(child(n, child_pos{0}) == value, "");
   }
 
@@ -268,6 +353,45 @@ template <int nd> struct tree {
   /// Is node \p n part of a free sibling group?
   bool is_free(node_idx n) const noexcept { return is_free(sibling_group(n)); }
 
+ public:
+  /// First free sibling group
+  ///
+  /// \returns sibling_group_capacity() if the tree is full
+  siblings_idx first_free_sibling_group() const noexcept {
+    return first_free_sibling_group_;
+  }
+
+  /// First free sibling group at position >= \p s
+  ///
+  /// \returns last_sg() if there is no such sibling group
+  ///
+  /// Time complexity: O(log_64(N)) (independent of the fragmentation)
+  siblings_idx next_free_sibling_group(siblings_idx s) const noexcept {
+    const auto n = free_sibling_groups_.find_next(*s);
+    return n != free_sibling_groups_.size() ? siblings_idx{n} : last_sg();
+  }
+
+  /// First sibling group in use at position >= \p s
+  ///
+  /// \returns sibling_group_capacity() if there is no such sibling group
+  ///
+  /// Time complexity: O(G / 64), where G is the number of sibling groups
+  /// between \p s and the returned one.
+  siblings_idx next_sibling_group_in_use(siblings_idx s) const noexcept {
+    const auto n = free_sibling_groups_.find_next_unset(*s);
+    return n != free_sibling_groups_.size() ? siblings_idx{n} : last_sg();
+  }
+
+ private:
+  /// Updates the free sibling group bit of \p s from its parent
+  void update_free_sibling_group(siblings_idx s) noexcept {
+    if (is_free(s)) {
+      free_sibling_groups_.set(*s);
+    } else {
+      free_sibling_groups_.reset(*s);
+    }
+  }
+
  public:
   /// Is node \p n a leaf node? (That is, does it have zero children?)
   bool is_leaf(node_idx n) const noexcept { return !first_child(n); }
@@ -314,11 +438,159 @@ template <int nd> struct tree {
   /// Maximum number of sibling groups that the tree can hold
   siblings_idx sibling_group_capacity() const noexcept { return sg_capacity_; }
 
-  /// Maximum number of nodes that the tree can hold
+  /// Maximum number of sibling groups representable with index_t
+  ///
+  /// All node indices must be smaller than the invalid index.
+  static constexpr siblings_idx max_sibling_group_capacity() noexcept {
+    return siblings_idx{
+     (std::min(static_cast<uint_t>(invalid_index()),
+               static_cast<uint_t>(std::numeric_limits<int>::max()))
+      - 1_u)
+      / no_children()
+     + 1_u};
+  }
+
+  /// Maximum number of nodes that the tree can hold without reallocating
   node_idx capacity() const noexcept {
     return no_nodes(sibling_group_capacity());
   }
 
+ private:
+  /// Reallocates the tree storage to hold \p new_sg_capacity sibling groups
+  ///
+  /// \pre all sibling groups in use must be < new_sg_capacity
+  /// \post sibling_group_capacity() == new_sg_capacity
+  ///
+  /// Node and sibling group indices remain valid.
+  ///
+  /// \returns the previous parent and first child arrays, e.g., to release
+  /// them once no reader uses them anymore (see epoch_tree)
+  std::pair<indices_t, indices_t> reallocate(siblings_idx new_sg_capacity) {
+    NDTREE_ASSERT(new_sg_capacity > 0_sg, "cannot reallocate to zero capacity");
+    NDTREE_ASSERT(new_sg_capacity <= max_sibling_group_capacity(),
+                  "capacity of {} sibling groups exceeds the maximum {} for "
+                  "the index type",
+                  new_sg_capacity, max_sibling_group_capacity());
+    NDTREE_ASSERT(new_sg_capacity >= last_sg()
+                   or all_of(boxed_ints<siblings_idx>(new_sg_capacity,
+                                                      last_sg()),
+                             [&](siblings_idx s) { return is_free(s); }),
+                  "cannot reallocate: sibling groups in use beyond new "
+                  "capacity {}",
+                  new_sg_capacity);
+    const auto new_capacity = no_nodes(new_sg_capacity);
+    auto new_parents = make_indices(*new_sg_capacity);
+    auto new_first_children = make_indices(*new_capacity);
+    {  // copy parents_
+      auto b = parents_.get();
+      auto e = b + std::min(*sibling_group_capacity(), *new_sg_capacity);
+      copy(b, e, new_parents.get());
+    }
+    {  // copy first_children_
+      auto b = first_children_.get();
+      auto e = b + std::min(*capacity(), *new_capacity);
+      copy(b, e, new_first_children.get());
+    }
+    ranges::swap(parents_, new_parents);
+    ranges::swap(first_children_, new_first_children);
+    levels_ = copy_sg_data(levels_, *sibling_group_capacity(),
+                           *new_sg_capacity);
+    locations_ = copy_sg_data(locations_, *sibling_group_capacity(),
+                              *new_sg_capacity);
+    hashes_ = copy_sg_data(hashes_, *sibling_group_capacity(),
+                           *new_sg_capacity);
+    free_sibling_groups_.resize(*new_sg_capacity, true);
+    sg_capacity_ = new_sg_capacity;
+    first_free_sibling_group_ = next_free_sibling_group(first_sg());
+    return std::make_pair(std::move(new_parents),
+                          std::move(new_first_children));
+  }
+
+  /// Grows the capacity geometrically to hold at least \p node_capacity
+  /// nodes (or as many nodes as the index type allows)
+  void grow(uint_t node_capacity) {
+    if (node_capacity <= *capacity()) { return; }
+    const auto max_sg_capacity = *max_sibling_group_capacity();
+    node_capacity = std::min(node_capacity, *no_nodes(max_sg_capacity));
+    const auto new_sg_capacity = std::min(
+     std::max(*no_sibling_groups(node_idx{node_capacity}),
+              2 * *sibling_group_capacity()),
+     max_sg_capacity);
+    if (new_sg_capacity == *sibling_group_capacity()) { return; }
+    reallocate(siblings_idx{new_sg_capacity});
+  }
+
+  /// Grows the capacity geometrically if the tree is full
+  ///
+  /// \returns false if the tree is full and cannot grow
+  bool grow_if_full() {
+    if (NDTREE_LIKELY(size() != capacity())) { return true; }
+    grow(*capacity() + 1);
+    return size() != capacity();
+  }
+
+  /// Sorts the nodes \p ns in depth-first order
+  ///
+  /// Time complexity: O(M * L + M log(M) * L), where M is the number of nodes
+  /// and L their maximum level.
+  void sort_depth_first(std::vector<node_idx>& ns) const {
+    // root-to-node paths (positions in parent) of all nodes are stored
+    // contiguously: the path of ns[i] is [offsets[i], offsets[i + 1])
+    std::vector<uint_t> paths;
+    std::vector<std::size_t> offsets(ns.size() + 1, 0);
+    for (std::size_t i = 0, e = ns.size(); i != e; ++i) {
+      const auto first = paths.size();
+      for (auto n = ns[i]; !is_root(n); n = parent(n)) {
+        paths.push_back(position_in_parent(n));
+      }
+      std::reverse(paths.begin() + first, paths.end());
+      offsets[i + 1] = paths.size();
+    }
+
+    // a node precedes another in depth-first order if its path is
+    // lexicographically smaller:
+    std::vector<std::size_t> order(ns.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    auto path_begin = [&](std::size_t i) { return paths.data() + offsets[i]; };
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return std::lexicographical_compare(path_begin(a), path_begin(a + 1),
+                                          path_begin(b), path_begin(b + 1));
+    });
+
+    std::vector<node_idx> sorted;
+    sorted.reserve(ns.size());
+    for (auto&& i : order) { sorted.push_back(ns[i]); }
+    ns = std::move(sorted);
+  }
+
+ public:
+  /// Increases the capacity of the tree to at least \p node_capacity nodes
+  ///
+  /// Node indices remain valid.
+  ///
+  /// Time complexity: O(N) if the tree is reallocated, O(1) otherwise.
+  void reserve(uint_t node_capacity) {
+    const auto new_sg_capacity = no_sibling_groups(node_idx{node_capacity});
+    if (new_sg_capacity <= sibling_group_capacity()) { return; }
+    reallocate(new_sg_capacity);
+  }
+
+  /// Reduces the capacity of the tree to the last sibling group in use
+  ///
+  /// Node indices remain valid. Call dfs_sort before to release all free
+  /// sibling groups.
+  ///
+  /// Time complexity: O(N)
+  void shrink_to_fit() {
+    auto new_sg_capacity = last_sg();
+    while (new_sg_capacity > 1_sg
+           and is_free(siblings_idx{*new_sg_capacity - 1})) {
+      new_sg_capacity = siblings_idx{*new_sg_capacity - 1};
+    }
+    if (new_sg_capacity == sibling_group_capacity()) { return; }
+    reallocate(new_sg_capacity);
+  }
+
  private:
   /// All parents as stored in memory
   constexpr auto all_parents() const noexcept {
@@ -337,36 +609,74 @@ template <int nd> struct tree {
   /// Is the tree empty?
   bool empty() const noexcept { return size_ == 0_n; }
 
+ private:
+  /// Marks the free sibling group \p s as in use
+  ///
+  /// first_free_sibling_group_ is not updated.
+  void acquire_sibling_group(siblings_idx s) noexcept {
+    NDTREE_ASSERT(free_sibling_groups_.test(*s), "sg {} is not free", *s);
+    size_ += node_idx{no_children()};
+    free_sibling_groups_.reset(*s);
+  }
+
+  /// Marks the sibling group \p s as free
+  ///
+  /// first_free_sibling_group_ is not updated.
+  void release_sibling_group(siblings_idx s) noexcept {
+    NDTREE_ASSERT(!free_sibling_groups_.test(*s), "sg {} is already free", *s);
+    size_ -= node_idx{no_children()};
+    free_sibling_groups_.set(*s);
+  }
+
+  /// Links the sibling group \p s as the children group of the leaf node
+  /// \p p (and updates the caches of \p s)
+  ///
+  /// Only the parent of \p s and the first child of \p p are written.
+  void link_children(node_idx p, siblings_idx s) {
+    set_parent(s, p);
+    set_first_child(p, first_node(s));
+    update_level(s);
+    update_location(s);
+    index_locations(s);
+    update_subtree_hashes(p);
+  }
+
+  /// Unlinks the children group of node \p p from \p p
+  ///
+  /// Only the parent of the children group and the first child of \p p are
+  /// written.
+  ///
+  /// \returns the unlinked children group
+  siblings_idx unlink_children(node_idx p) noexcept {
+    const auto cg = children_group(p);
+    NDTREE_ASSERT(!is_free(cg), "node {}: its child group {} is free", *p, *cg);
+    unindex_locations(cg);
+    set_parent(cg, node_idx{});
+    set_first_child(p, node_idx{});
+    return cg;
+  }
+
+ public:
   /// Refine node \p p and returns children group idx
   ///
-  /// If refinement failed returns nothing.
+  /// If the tree is full its capacity is doubled (node indices remain valid).
+  /// If the capacity cannot grow further because of the index type, the
+  /// refinement fails and an invalid sibling group is returned.
   ///
   /// \pre !is_free(p) && is_leaf(p)
   /// \post !is_free(p) && !is_leaf(p)
-  siblings_idx refine(node_idx p) noexcept {
+  siblings_idx refine(node_idx p) {
     NDTREE_ASSERT(!is_free(p), "node {}: is free and cannot be refined", *p);
     NDTREE_ASSERT(is_leaf(p), "node {}: is not a leaf and cannot be refined",
                   *p);
-    if (size() == capacity()) { return siblings_idx{}; }
+    if (!grow_if_full()) { return siblings_idx{}; }
 
     const auto s = first_free_sibling_group_;
     NDTREE_ASSERT(is_free(s), "node {}: first free sg {} is not free", *p, *s);
 
-    size_ += node_idx{no_children()};
-
-    ++first_free_sibling_group_;
-    auto remaining_sgs
-     = boxed_ints<siblings_idx>(first_free_sibling_group_, last_sg());
-    NDTREE_STATIC_ASSERT_RANDOM_ACCESS_SIZED_RANGE(remaining_sgs);
-
-    auto next_unused_sg_it
-     = find_if(remaining_sgs, [&](siblings_idx i) { return is_free(i); });
-    if (next_unused_sg_it != end(remaining_sgs)) {
-      first_free_sibling_group_ = *next_unused_sg_it;
-    }
-
-    set_parent(s, p);
-    set_first_child(p, first_node(s));
+    acquire_sibling_group(s);
+    first_free_sibling_group_ = next_free_sibling_group(siblings_idx{*s + 1});
+    link_children(p, s);
 
     NDTREE_ASSERT(!is_free(s), "node {}: refine produced a free sg {}", *p, *s);
     NDTREE_ASSERT(all_of(children(p), [&](node_idx i) { return is_leaf(i); }),
@@ -377,6 +687,53 @@ template <int nd> struct tree {
     return s;
   }
 
+  /// Refines the nodes of the range \p ns
+  ///
+  /// All children groups are allocated in a single pass: they are placed in
+  /// the free sibling groups (in increasing order) following the depth-first
+  /// order of their parents. Memory is reallocated at most once. If the tree
+  /// was compact the children groups are stored contiguously after the last
+  /// sibling group in use.
+  ///
+  /// \returns number of refined nodes (smaller than the number of unique
+  /// nodes in \p ns only if the tree cannot grow further due to its index
+  /// type)
+  ///
+  /// \pre !is_free(p) && is_leaf(p) for all p in ns
+  /// \post !is_free(p) && !is_leaf(p) for all refined p in ns
+  ///
+  /// Time complexity: O(M log(M) * L + M * log_64(N)) where M is the number of
+  /// nodes in \p ns and L their maximum level.
+  template <typename Rng, CONCEPT_REQUIRES_(Range<Rng>{})>
+  uint_t refine(Rng&& ns) {
+    std::vector<node_idx> ps;
+    RANGES_FOR(auto&& n, ns) { ps.push_back(n); }
+    sort_depth_first(ps);
+    ps.erase(std::unique(ps.begin(), ps.end()), ps.end());
+
+    grow(*size() + ps.size() * no_children());
+
+    uint_t no_refined = 0;
+    auto s = first_free_sibling_group_;
+    for (auto&& p : ps) {
+      NDTREE_ASSERT(!is_free(p), "node {}: is free and cannot be refined", *p);
+      NDTREE_ASSERT(is_leaf(p), "node {}: is not a leaf and cannot be refined",
+                    *p);
+      if (size() == capacity()) { break; }
+      NDTREE_ASSERT(is_free(s), "node {}: free sg {} is not free", *p, *s);
+
+      acquire_sibling_group(s);
+      link_children(p, s);
+      ++no_refined;
+
+      s = next_free_sibling_group(siblings_idx{*s + 1});
+    }
+    first_free_sibling_group_ = s;
+    NDTREE_ASSERT(s == next_free_sibling_group(first_sg()),
+                  "batched refine produced invalid first free sg {}", *s);
+    return no_refined;
+  }
+
   /// Coarsen node \p p
   ///
   /// \pre !is_free(p) && !is_leaf(p) && is_leaf(children group of p)
@@ -385,22 +742,107 @@ template <int nd> struct tree {
     NDTREE_ASSERT(!is_free(p), "node {}: is free, cannot coarsen", *p);
     NDTREE_ASSERT(!is_leaf(p), "node {}: is leaf, cannot coarsen", *p);
 
+    const auto cg = unlink_children(p);
+    release_sibling_group(cg);
+    if (*cg < *first_free_sibling_group_) { first_free_sibling_group_ = cg; }
+    update_subtree_hashes(p);
+
+    NDTREE_ASSERT(is_free(cg), "node {}: after coarsen child group {} not free",
+                  *p, *cg);
+    NDTREE_ASSERT(is_leaf(p), "node {}: after coarsen not leaf", *p);
+    NDTREE_ASSERT(!is_free(p), "node {}: after coarsen is free", *p);
+  }
+
+ private:
+  /// Releases all descendants of node \p p (bottom-up)
+  ///
+  /// The restriction \p r is called on each non-leaf node of the subtree
+  /// while its children are still valid (that is, all its children are
+  /// leaves, but have not been released yet).
+  ///
+  /// first_free_sibling_group_ is not updated.
+  ///
+  /// \returns the smallest released sibling group
+  template <typename Restriction>
+  siblings_idx release_descendants(node_idx p, Restriction& r) {
     const auto cg = children_group(p);
     NDTREE_ASSERT(!is_free(cg), "node {}: its child group {} is free", *p, *cg);
+    auto min_sg = cg;
+    RANGES_FOR(auto&& c, nodes(cg)) {
+      if (is_leaf(c)) { continue; }
+      const auto s = release_descendants(c, r);
+      if (*s < *min_sg) { min_sg = s; }
+    }
 
-    size_ -= node_idx{no_children()};
+    r(p);
 
-    if (*cg < *first_free_sibling_group_) { first_free_sibling_group_ = cg; }
+    release_sibling_group(unlink_children(p));
+    return min_sg;
+  }
 
-    set_parent(cg, node_idx{});
-    set_first_child(p, node_idx{});
+ public:
+  /// Coarsens the subtree rooted at node \p p: releases all its descendants
+  ///
+  /// The restriction \p r is called with each non-leaf node of the subtree
+  /// (bottom-up, the children of a node before the node itself) before its
+  /// children are released, e.g., to restrict the children data into it.
+  ///
+  /// \pre !is_free(p) && !is_leaf(p)
+  /// \post !is_free(p) && is_leaf(p)
+  ///
+  /// Time complexity: O(M), where M is the number of nodes in the subtree.
+  template <typename Restriction>
+  void coarsen_subtree(node_idx p, Restriction&& r) {
+    NDTREE_ASSERT(!is_free(p), "node {}: is free, cannot coarsen", *p);
+    NDTREE_ASSERT(!is_leaf(p), "node {}: is leaf, cannot coarsen", *p);
+
+    const auto s = release_descendants(p, r);
+    if (*s < *first_free_sibling_group_) { first_free_sibling_group_ = s; }
+    update_subtree_hashes(p);
 
-    NDTREE_ASSERT(is_free(cg), "node {}: after coarsen child group {} not free",
-                  *p, *cg);
     NDTREE_ASSERT(is_leaf(p), "node {}: after coarsen not leaf", *p);
     NDTREE_ASSERT(!is_free(p), "node {}: after coarsen is free", *p);
   }
 
+  /// Coarsens the subtree rooted at node \p p
+  void coarsen_subtree(node_idx p) {
+    coarsen_subtree(p, [](node_idx) {});
+  }
+
+  /// Coarsens the subtrees rooted at the nodes of the range \p ns
+  ///
+  /// Nodes that are leaves, or that have been released while coarsening a
+  /// previous node of the range, are skipped. The restriction \p r is called
+  /// as in coarsen_subtree.
+  ///
+  /// \returns number of coarsened nodes
+  ///
+  /// Time complexity: O(M), where M is the number of released nodes.
+  template <typename Rng, typename Restriction,
+            CONCEPT_REQUIRES_(Range<Rng>{})>
+  uint_t coarsen(Rng&& ns, Restriction&& r) {
+    uint_t no_coarsened = 0;
+    auto min_sg = first_free_sibling_group_;
+    RANGES_FOR(auto&& n, ns) {
+      const node_idx p = n;
+      if (is_free(p) or is_leaf(p)) { continue; }
+      const auto s = release_descendants(p, r);
+      if (*s < *min_sg) { min_sg = s; }
+      update_subtree_hashes(p);
+      ++no_coarsened;
+    }
+    first_free_sibling_group_ = min_sg;
+    NDTREE_ASSERT(min_sg == next_free_sibling_group(first_sg()),
+                  "batched coarsen produced invalid first free sg {}", *min_sg);
+    return no_coarsened;
+  }
+
+  /// Coarsens the subtrees rooted at the nodes of the range \p ns
+  template <typename Rng, CONCEPT_REQUIRES_(Range<Rng>{})>
+  uint_t coarsen(Rng&& ns) {
+    return coarsen(std::forward<Rng>(ns), [](node_idx) {});
+  }
+
  private:
   /// Initializes the tree with a root node
   ///
@@ -411,6 +853,7 @@ template <int nd> struct tree {
     NDTREE_ASSERT(!parent(0_sg), "first sibling group has a parent");
     NDTREE_ASSERT(is_leaf(0_n), "root node already has children");
     ++size_;
+    free_sibling_groups_.reset(0);
     ++first_free_sibling_group_;
     NDTREE_ASSERT(size() == 1, "after root node init size is {} and not 1",
                   size());
@@ -419,8 +862,10 @@ template <int nd> struct tree {
   /// Is the tree reseted?
   bool is_reseted() {
     return size_ == 0 and first_free_sibling_group_ == 0_sg
-           and all_of(all_parents(), [](node_idx i) { return !i; })
-           and all_of(all_children(), [](node_idx i) { return !i; });
+           and all_of(all_parents(),
+                      [](index_t i) { return i == invalid_index(); })
+           and all_of(all_children(),
+                      [](index_t i) { return i == invalid_index(); });
   }
 
  public:
@@ -462,20 +907,396 @@ template <int nd> struct tree {
       update_parent_sibling_e(p_b, a);
     }
 
-    /// 3) update the first free sibling group flag:
-    ///    - if one of the nodes is inactive:
-    auto update_first_free_sg = [&](siblings_idx i, siblings_idx j) {
-      if (is_free(i)) {
-        first_free_sibling_group_
-         = (j == first_free_sibling_group_) ? i : first_free_sibling_group_;
-      }
+    /// 3) update the free sibling groups and the first free sibling group:
+    update_free_sibling_group(a);
+    update_free_sibling_group(b);
+    first_free_sibling_group_ = next_free_sibling_group(first_sg());
+
+    /// 4) swap the cached levels, locations, and subtree hashes:
+    if (has_level_cache()) { ranges::swap(levels_[*a], levels_[*b]); }
+    if (has_location_cache()) {
+      ranges::swap(locations_[*a], locations_[*b]);
+    }
+    if (has_subtree_hashes()) { ranges::swap(hashes_[*a], hashes_[*b]); }
+
+    /// 5) update the node indices of the swapped locations:
+    index_locations(a);
+    index_locations(b);
+  }
+
+  /// Moves the sibling groups in use to the positions given by \p new_to_old
+  ///
+  /// The sibling group new_to_old[i] is moved to the position i. The tree
+  /// arrays are rebuilt out-of-place with one sequential pass, which is split
+  /// among \p no_threads threads.
+  ///
+  /// \returns the node permutation: the node at position i after the call was
+  /// the node result[i] before. Node data can be permuted with one gather per
+  /// array: new_data[i] = old_data[result[i]] for all i in [0, size()).
+  ///
+  /// \pre new_to_old[0] == 0 (the root sibling group)
+  /// \pre new_to_old contains each sibling group in use exactly once
+  /// \post is_compact()
+  ///
+  /// Time complexity: O(N / no_threads)
+  /// Space complexity: O(N) (the tree arrays are reallocated)
+  std::vector<node_idx> permute(std::vector<siblings_idx> const& new_to_old,
+                                uint_t no_threads = 1) {
+    const auto no_sgs = static_cast<uint_t>(new_to_old.size());
+    NDTREE_ASSERT(no_sgs == *sibling_group(size()),
+                  "the permutation has {} sibling groups but {} are in use",
+                  no_sgs, *sibling_group(size()));
+    NDTREE_ASSERT(no_sgs == 0 or is_root(new_to_old[0]),
+                  "the root sibling group must remain the first one");
+
+    std::vector<siblings_idx> old_to_new(*sibling_group_capacity());
+    parallel_for(no_threads, 0, no_sgs, [&](uint_t i) {
+      NDTREE_ASSERT(!is_free(new_to_old[i]), "sibling group {} is free",
+                    *new_to_old[i]);
+      old_to_new[*new_to_old[i]] = siblings_idx{i};
+    });
+    auto new_node = [&](node_idx n) {
+      if (!n or is_root(n)) { return n; }
+      return node_idx{*first_node(old_to_new[*sibling_group(n)])
+                      + position_in_parent(n)};
     };
-    update_first_free_sg(a, b);
-    update_first_free_sg(b, a);
+
+    auto parents = make_indices(*sibling_group_capacity());
+    auto first_children = make_indices(*capacity());
+    std::vector<node_idx> nodes_new_to_old(*size());
+    parallel_for(no_threads, 0, no_sgs, [&](uint_t i) {
+      const auto old_s = new_to_old[i];
+      parents[i] = store(new_node(parent(old_s)));
+      auto new_n = *first_node(siblings_idx{i});
+      RANGES_FOR(auto&& n, nodes(old_s)) {
+        first_children[new_n] = store(new_node(first_child(n)));
+        nodes_new_to_old[new_n] = n;
+        ++new_n;
+      }
+    });
+    parents_ = std::move(parents);
+    first_children_ = std::move(first_children);
+    levels_ = gather_sg_data(levels_, new_to_old, no_threads);
+    locations_ = gather_sg_data(locations_, new_to_old, no_threads);
+    hashes_ = gather_sg_data(hashes_, new_to_old, no_threads);
+    if (has_location_index()) {
+      location_index_->clear();
+      for (uint_t i = 0; i != no_sgs; ++i) { index_locations(siblings_idx{i}); }
+    }
+
+    free_sibling_groups_ = hierarchical_bitset(*sibling_group_capacity(), true);
+    free_sibling_groups_.reset(0, no_sgs);
+    first_free_sibling_group_ = siblings_idx{no_sgs};
+
+    NDTREE_ASSERT(is_compact(), "the tree must be compact after permute");
+    return nodes_new_to_old;
   }
 
   ///@}  // Memory management
 
+  /// \name Optional per sibling group data (caches)
+  ///
+  ///@{
+
+ private:
+  /// Copy of the first min(\p n, \p m) elements of the per sibling group
+  /// array \p a into a new array of \p m elements (null if \p a is null)
+  template <typename T>
+  static std::unique_ptr<T[]> copy_sg_data(std::unique_ptr<T[]> const& a,
+                                           uint_t n, uint_t m) {
+    if (!a) { return nullptr; }
+    auto r = std::make_unique<T[]>(m);
+    std::copy(a.get(), a.get() + std::min(n, m), r.get());
+    return r;
+  }
+
+  /// Per sibling group array with the elements of \p a permuted as in
+  /// permute: result[i] = a[new_to_old[i]] (null if \p a is null)
+  template <typename T>
+  std::unique_ptr<T[]> gather_sg_data(
+   std::unique_ptr<T[]> const& a, std::vector<siblings_idx> const& new_to_old,
+   uint_t no_threads) const {
+    if (!a) { return nullptr; }
+    auto r = std::make_unique<T[]>(*sibling_group_capacity());
+    parallel_for(no_threads, 0, new_to_old.size(),
+                 [&](uint_t i) { r[i] = a[*new_to_old[i]]; });
+    return r;
+  }
+
+  /// Calls \p f on every sibling group in use, with parent sibling groups
+  /// visited before their children groups
+  template <typename F> void for_each_sibling_group_top_down(F&& f) const {
+    std::vector<siblings_idx> stack{first_sg()};
+    while (!stack.empty()) {
+      const auto s = stack.back();
+      stack.pop_back();
+      f(s);
+      for (auto&& n : nodes(s) | with_children()) {
+        stack.push_back(children_group(n));
+      }
+    }
+  }
+
+  ///@}  // Optional per sibling group data
+
+  /// \name Level cache (optional)
+  ///
+  /// Stores the level of each sibling group (1 byte / sibling group) so that
+  /// the level of a node can be obtained with one load. It is kept up-to-date
+  /// by refine, coarsen, swap, and permute.
+  ///
+  ///@{
+
+ private:
+  /// Sets the level of the sibling group \p s from the level of its parent
+  void update_level(siblings_idx s) noexcept {
+    if (!has_level_cache()) { return; }
+    const auto p = parent(s);
+    const uint_t l = p ? level(p) + 1 : 0;
+    NDTREE_ASSERT(l <= std::numeric_limits<std::uint8_t>::max(),
+                  "level {} of sibling group {} does not fit in the cache", l,
+                  *s);
+    levels_[*s] = static_cast<std::uint8_t>(l);
+  }
+
+ public:
+  /// Is the level of each sibling group stored?
+  bool has_level_cache() const noexcept { return static_cast<bool>(levels_); }
+
+  /// Stores the level of each sibling group
+  ///
+  /// Time complexity: O(N)
+  void enable_level_cache() {
+    if (has_level_cache()) { return; }
+    levels_ = std::make_unique<std::uint8_t[]>(*sibling_group_capacity());
+    for_each_sibling_group_top_down([&](siblings_idx s) { update_level(s); });
+  }
+
+  /// Releases the level cache
+  void disable_level_cache() noexcept { levels_.reset(); }
+
+  /// Level of the node \p n
+  ///
+  /// \pre has_level_cache()
+  ///
+  /// Time complexity: O(1)
+  uint_t level(node_idx n) const noexcept {
+    NDTREE_ASSERT(has_level_cache(), "the level cache is not enabled");
+    NDTREE_ASSERT(!is_free(n), "node {} is free", *n);
+    return levels_[*sibling_group(n)];
+  }
+
+  ///@}  // Level cache
+
+  /// \name Location cache (optional)
+  ///
+  /// Stores the location of the first node of each sibling group (1
+  /// location_t / sibling group). The location of a node is then its sibling
+  /// group location plus its position in parent. The children locations are
+  /// computed at refine time from the location of their parent, and the
+  /// cached locations move with the sibling groups on swap and permute.
+  ///
+  /// \pre the tree depth does not exceed location_t::max_level()
+  ///
+  ///@{
+
+ private:
+  /// Sets the location of the sibling group \p s from the location of its
+  /// parent
+  void update_location(siblings_idx s) noexcept {
+    if (!has_location_cache()) { return; }
+    const auto p = parent(s);
+    auto l = p ? location(p) : location_t{};
+    if (p) { l.push(0); }
+    locations_[*s] = l;
+  }
+
+ public:
+  /// Is the location of each sibling group stored?
+  bool has_location_cache() const noexcept {
+    return static_cast<bool>(locations_);
+  }
+
+  /// Stores the location of each sibling group
+  ///
+  /// Time complexity: O(N)
+  void enable_location_cache() {
+    if (has_location_cache()) { return; }
+    locations_ = std::make_unique<location_t[]>(*sibling_group_capacity());
+    for_each_sibling_group_top_down(
+     [&](siblings_idx s) { update_location(s); });
+  }
+
+  /// Releases the location cache (and the location index)
+  void disable_location_cache() noexcept {
+    disable_location_index();
+    locations_.reset();
+  }
+
+  /// Location of the node \p n
+  ///
+  /// \pre has_location_cache()
+  ///
+  /// Time complexity: O(1)
+  location_t location(node_idx n) const noexcept {
+    NDTREE_ASSERT(has_location_cache(), "the location cache is not enabled");
+    NDTREE_ASSERT(!is_free(n), "node {} is free", *n);
+    auto l = locations_[*sibling_group(n)];
+    if (!is_root(n)) { l.value += position_in_parent(n); }
+    return l;
+  }
+
+  ///@}  // Location cache
+
+  /// \name Location index (optional)
+  ///
+  /// Hash map from the location of each node to its index, so that the node
+  /// at a given location can be found with one lookup instead of a
+  /// root-to-node traversal. It is built on top of the location cache, and is
+  /// kept up-to-date by refine, coarsen, swap, and permute.
+  ///
+  ///@{
+
+ private:
+  /// Maps the locations of the nodes of the sibling group \p s to their
+  /// indices
+  void index_locations(siblings_idx s) {
+    if (!has_location_index() or is_free(s)) { return; }
+    RANGES_FOR(auto&& n, nodes(s)) {
+      location_index_->insert_or_assign(location(n).value, store(n));
+    }
+  }
+
+  /// Reserves space in the location index for \p no_nodes nodes, so that
+  /// indexing them does not allocate
+  void reserve_location_index(uint_t no_nodes) {
+    if (has_location_index()) { location_index_->reserve(no_nodes); }
+  }
+
+  /// Removes the locations of the nodes of the sibling group \p s from the
+  /// index
+  void unindex_locations(siblings_idx s) noexcept {
+    if (!has_location_index()) { return; }
+    RANGES_FOR(auto&& n, nodes(s)) {
+      location_index_->erase(location(n).value);
+    }
+  }
+
+ public:
+  /// Is the node at each location indexed?
+  bool has_location_index() const noexcept {
+    return static_cast<bool>(location_index_);
+  }
+
+  /// Indexes the node at each location (enables the location cache)
+  ///
+  /// Time complexity: O(N)
+  void enable_location_index() {
+    if (has_location_index()) { return; }
+    enable_location_cache();
+    location_index_ = std::make_unique<location_index_t>(*size());
+    for_each_sibling_group_top_down(
+     [&](siblings_idx s) { index_locations(s); });
+  }
+
+  /// Releases the location index
+  void disable_location_index() noexcept { location_index_.reset(); }
+
+  /// Index of the node at the location \p l (invalid if there is no node at
+  /// that location)
+  ///
+  /// \pre has_location_index()
+  ///
+  /// Time complexity: O(1) expected
+  node_idx node_at(location_t l) const noexcept {
+    NDTREE_ASSERT(has_location_index(), "the location index is not enabled");
+    if (!l.valid()) { return node_idx{}; }
+    auto i = location_index_->find(l.value);
+    return i ? load(*i) : node_idx{};
+  }
+
+  ///@}  // Location index
+
+  /// \name Subtree hashes (optional)
+  ///
+  /// Merkle-style hash of the subtree of each node: a leaf has a constant
+  /// hash, and the hash of a node with children is the hash of the sequence
+  /// of the hashes of its children. It is stored per children group (1 word /
+  /// sibling group), depends only on the shape of the subtree (not on the
+  /// node indices), and is kept up-to-date by refine and coarsen, which
+  /// recompute the hashes of the ancestors of the modified node (O(L) for a
+  /// node at level L).
+  ///
+  /// Equal subtrees have equal hashes; different subtrees have different
+  /// hashes with probability 1 - 2^-64.
+  ///
+  ///@{
+
+ private:
+  /// Hash of the sequence of subtree hashes of the nodes of sibling group
+  /// \p s
+  std::uint64_t sibling_group_hash(siblings_idx s) const noexcept {
+    std::uint64_t h = 0x9E3779B97F4A7C15ull;
+    RANGES_FOR(auto&& n, nodes(s)) {
+      h = (h ^ subtree_hash(n)) * 0xFF51AFD7ED558CCDull;
+      h ^= h >> 32;
+    }
+    return h;
+  }
+
+  /// Updates the subtree hashes of node \p p and of its ancestors after
+  /// its children have been linked or unlinked
+  void update_subtree_hashes(node_idx p) noexcept {
+    if (!has_subtree_hashes()) { return; }
+    if (const auto s = children_group(p)) {
+      hashes_[*s] = sibling_group_hash(s);
+    }
+    for (; !is_root(p); p = parent(p)) {
+      const auto s = sibling_group(p);
+      hashes_[*s] = sibling_group_hash(s);
+    }
+  }
+
+ public:
+  /// Are the subtree hashes stored?
+  bool has_subtree_hashes() const noexcept {
+    return static_cast<bool>(hashes_);
+  }
+
+  /// Stores the subtree hash of each node
+  ///
+  /// Time complexity: O(N)
+  void enable_subtree_hashes() {
+    if (has_subtree_hashes()) { return; }
+    std::vector<siblings_idx> sgs;
+    for_each_sibling_group_top_down([&](siblings_idx s) { sgs.push_back(s); });
+    hashes_ = std::make_unique<std::uint64_t[]>(*sibling_group_capacity());
+    // children groups before their parents:
+    for (auto it = sgs.rbegin(); it != sgs.rend(); ++it) {
+      hashes_[**it] = sibling_group_hash(*it);
+    }
+  }
+
+  /// Releases the subtree hashes
+  void disable_subtree_hashes() noexcept { hashes_.reset(); }
+
+  /// Hash of the subtree rooted at node \p n
+  ///
+  /// Subtrees with different hashes have different shapes. Equal hashes
+  /// do not prove that the shapes are equal (hashes can collide).
+  ///
+  /// \pre has_subtree_hashes()
+  ///
+  /// Time complexity: O(1)
+  std::uint64_t subtree_hash(node_idx n) const noexcept {
+    NDTREE_ASSERT(has_subtree_hashes(), "the subtree hashes are not enabled");
+    NDTREE_ASSERT(!is_free(n), "node {} is free", *n);
+    const auto s = children_group(n);
+    return s ? hashes_[*s] : 0;
+  }
+
+  ///@}  // Subtree hashes
+
  public:
   tree() = default;
 
@@ -483,10 +1304,15 @@ template <int nd> struct tree {
   /// with a root node
   tree(uint_t node_capacity)
    : sg_capacity_(no_sibling_groups(node_capacity))
-   , parents_(std::make_unique<node_idx[]>(*sibling_group_capacity()))
-   , first_children_(std::make_unique<node_idx[]>(*capacity())) {
+   , parents_(make_indices(*sibling_group_capacity()))
+   , first_children_(make_indices(*capacity()))
+   , free_sibling_groups_(*sibling_group_capacity(), true) {
     NDTREE_ASSERT(capacity() > 0_n,
                   "cannot construct tree with zero capacity ({})", capacity());
+    NDTREE_ASSERT(sibling_group_capacity() <= max_sibling_group_capacity(),
+                  "capacity {} exceeds the maximum capacity {} of the index "
+                  "type",
+                  capacity(), no_nodes(max_sibling_group_capacity()));
     NDTREE_ASSERT(is_reseted(), "tree is not reseted");
     initialize_root_node();
   }
@@ -496,6 +1322,7 @@ template <int nd> struct tree {
   tree(tree const& other) : tree(*other.capacity()) {
     size_ = other.size_;
     first_free_sibling_group_ = other.first_free_sibling_group_;
+    free_sibling_groups_ = other.free_sibling_groups_;
     {  // copy parents_
       auto b = other.parents_.get();
       auto e = b + *other.sibling_group_capacity();
@@ -508,21 +1335,86 @@ template <int nd> struct tree {
       auto o = first_children_.get();
       copy(b, e, o);
     }
+    levels_ = copy_sg_data(other.levels_, *other.sibling_group_capacity(),
+                           *sibling_group_capacity());
+    locations_ = copy_sg_data(other.locations_, *other.sibling_group_capacity(),
+                              *sibling_group_capacity());
+    hashes_ = copy_sg_data(other.hashes_, *other.sibling_group_capacity(),
+                           *sibling_group_capacity());
+    if (other.has_location_index()) {
+      location_index_
+       = std::make_unique<location_index_t>(*other.location_index_);
+    }
   }
 
   tree& operator=(tree other) {
     ranges::swap(*this, other);
     return *this;
   }
+
+  /// \name Raw storage
+  ///
+  /// In memory representation of the tree, e.g., to save it to a file that
+  /// can be memory mapped later (see serialization/mmap.hpp).
+  ///
+  ///@{
+
+  /// Parent index of each sibling group (sibling_group_capacity() indices,
+  /// the maximum value of index_t for free sibling groups)
+  index_t const* raw_parents() const noexcept { return parents_.get(); }
+
+  /// First child index of each node (capacity() indices, the maximum value
+  /// of index_t for leaf and free nodes)
+  index_t const* raw_first_children() const noexcept {
+    return first_children_.get();
+  }
+
+  /// Creates a tree with capacity for \p sg_capacity sibling groups from
+  /// the in memory representation of its indices \p parents and
+  /// \p first_children (as returned by raw_parents and raw_first_children)
+  ///
+  /// The arrays are not copied, so for mmap_storage they are only paged in
+  /// on access. Only the parents are read to find the free sibling groups.
+  ///
+  /// Time complexity: O(G), where G is the sibling group capacity.
+  tree(siblings_idx sg_capacity, indices_t parents, indices_t first_children)
+   : sg_capacity_(sg_capacity)
+   , parents_(std::move(parents))
+   , first_children_(std::move(first_children))
+   , free_sibling_groups_(*sibling_group_capacity(), true) {
+    NDTREE_ASSERT(sg_capacity > 0_sg, "cannot create a tree without capacity");
+    NDTREE_ASSERT(parents_ and first_children_, "invalid index arrays");
+    NDTREE_ASSERT(!parent(0_sg), "first sibling group has a parent");
+    uint_t no_sgs = 0;
+    for (uint_t i = 0; i != *sg_capacity; ++i) {
+      const siblings_idx s{i};
+      update_free_sibling_group(s);
+      if (!is_free(s)) { ++no_sgs; }
+    }
+    size_ = node_idx{1 + (no_sgs - 1) * no_children()};
+    first_free_sibling_group_ = next_free_sibling_group(first_sg());
+  }
+
+  ///@}  // Raw storage
 };
 
 /// Graph equality
 ///
 /// Two trees are equal if their parent-child graph is the same.
 ///
-template <int nd>
-bool operator==(tree<nd> const& a, tree<nd> const& b) noexcept {
+/// If both trees store subtree hashes, trees with different shapes are
+/// rejected in O(1) by comparing their root hashes. Equal hashes do not
+/// prove equality, so confirming it still takes O(N): O(1) rejection, O(N)
+/// confirmation.
+///
+template <int nd, typename Index, typename SA, typename SB>
+bool operator==(tree<nd, Index, SA> const& a,
+                tree<nd, Index, SB> const& b) noexcept {
   if (size(a) != size(b)) { return false; }
+  if (!a.empty() and a.has_subtree_hashes() and b.has_subtree_hashes()
+      and a.subtree_hash(0_n) != b.subtree_hash(0_n)) {
+    return false;
+  }
 
   RANGES_FOR(auto&& np, view::zip(a.nodes(), b.nodes())) {
     auto&& an = get<0>(np);
@@ -533,8 +1425,9 @@ bool operator==(tree<nd> const& a, tree<nd> const& b) noexcept {
   return true;
 }
 
-template <int nd>
-bool operator!=(tree<nd> const& a, tree<nd> const& b) noexcept {
+template <int nd, typename Index, typename SA, typename SB>
+bool operator!=(tree<nd, Index, SA> const& a,
+                tree<nd, Index, SB> const& b) noexcept {
   return !(a == b);
 }
 
@@ -6,7 +6,7 @@ namespace ndtree {
 inline namespace v1 {
 //
 
-#if !defined(NDTREE_32_BIT_TYPES) || !defined(NDTREE_64_BIT_TYPES)
+#if !defined(NDTREE_32_BIT_TYPES) && !defined(NDTREE_64_BIT_TYPES)
 using int_t = int_fast32_t;
 using uint_t = uint_fast32_t;
 using num_t = double;
@@ -46,8 +46,21 @@ constexpr siblings_idx operator"" _sg(unsigned long long int i) {
   return siblings_idx{static_cast<uint_t>(i)};
 }
 
+/// Default tree storage policy (see storage/heap.hpp)
+struct heap_storage;
+
 /// nd-tree
-template <int nd> struct tree;
+template <int nd, typename Index = uint_t, typename Storage = heap_storage>
+struct tree;
+
+/// nd-tree with internal synchronization (see concurrent_tree.hpp)
+template <int nd, typename Index = uint_t> struct concurrent_tree;
+
+/// nd-tree with epoch-based snapshots (see epoch_tree.hpp)
+template <int nd, typename Index = uint_t> struct epoch_tree;
+
+/// nd-tree with copy-on-write versions (see versioned_tree.hpp)
+template <int nd, typename Index = uint_t> struct versioned_tree;
 
 /// Child position range
 template <typename Tree> using child_pos = typename Tree::child_pos;
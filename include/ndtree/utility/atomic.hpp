@@ -0,0 +1,35 @@
+#pragma once
+/// \file atomic.hpp Atomic operations on plain (non std::atomic) memory
+#include <type_traits>
+
+namespace ndtree {
+inline namespace v1 {
+namespace atomic {
+//
+
+/// Loads \p *p with acquire semantics
+template <typename T> T load_acquire(T const* p) noexcept {
+  static_assert(std::is_integral<T>{}, "");
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+/// Stores \p v into \p *p with release semantics
+template <typename T> void store_release(T* p, T v) noexcept {
+  static_assert(std::is_integral<T>{}, "");
+  __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/// Replaces \p *p with \p desired if it equals \p expected (with release
+/// semantics on success)
+///
+/// \returns true on success
+template <typename T>
+bool compare_exchange(T* p, T expected, T desired) noexcept {
+  static_assert(std::is_integral<T>{}, "");
+  return __atomic_compare_exchange_n(p, &expected, desired, false,
+                                     __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+}  // namespace atomic
+}  // namespace v1
+}  // namespace ndtree
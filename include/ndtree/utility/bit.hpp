@@ -138,14 +138,36 @@ constexpr bool overflows_on_add(UInt value, UInt offset,
   return max_value(no_bits) - value < offset;
 }
 
+namespace detail {
+
+/// Number of leading zero bits of \p n (portable fallback)
+template <typename UInt> constexpr int clz(UInt n) noexcept {
+  int r = 0;
+  for (UInt m = UInt{1} << (CHAR_BIT * sizeof(n) - 1); m != 0 and !(n & m);
+       m >>= 1) {
+    ++r;
+  }
+  return r;
+}
+
+/// Number of trailing zero bits of \p n (portable fallback)
+template <typename UInt> constexpr int ctz(UInt n) noexcept {
+  if (n == 0) { return CHAR_BIT * sizeof(n); }
+  int r = 0;
+  for (; !(n & UInt{1}); n >>= 1) { ++r; }
+  return r;
+}
+
+}  // namespace detail
+
 template <typename Integer,
           CONCEPT_REQUIRES_(UnsignedIntegral<Integer>{}
                             and width<Integer> == width<unsigned int>)>
 constexpr int clz(Integer n) noexcept {
-#if defined(__GCC__) || defined(__clang__)
+#if defined(__GNUC__)  // also defined by clang
   return n == 0 ? sizeof(n) * CHAR_BIT : __builtin_clz(n);
 #else
-#pragma message "error compiler doesn't support clz(unsigned)"
+  return detail::clz(n);
 #endif
 }
 
@@ -155,10 +177,10 @@ template <
   UnsignedIntegral<Integer>{}
   and width<Integer> == width<unsigned long> and width<unsigned long> != width<unsigned int>)>
 constexpr int clz(Integer n) noexcept {
-#if defined(__GCC__) || defined(__clang__)
+#if defined(__GNUC__)  // also defined by clang
   return n == 0 ? sizeof(n) * CHAR_BIT : __builtin_clzl(n);
 #else
-#pragma message "error compiler doesn't support clz(unsigned long)"
+  return detail::clz(n);
 #endif
 }
 
@@ -168,13 +190,69 @@ template <
   UnsignedIntegral<Integer>{}
   and width<Integer> == width<unsigned long long> and width<unsigned long> != width<unsigned long long>)>
 constexpr int clz(Integer n) noexcept {
-#if defined(__GCC__) || defined(__clang__)
+#if defined(__GNUC__)  // also defined by clang
   return n == 0 ? sizeof(n) * CHAR_BIT : __builtin_clzll(n);
 #else
-#pragma message "error compiler doesn't support clz(unsigned long long)"
+  return detail::clz(n);
+#endif
+}
+
+template <typename Integer,
+          CONCEPT_REQUIRES_(UnsignedIntegral<Integer>{}
+                            and width<Integer> == width<unsigned int>)>
+constexpr int ctz(Integer n) noexcept {
+#if defined(__GNUC__)  // also defined by clang
+  return n == 0 ? sizeof(n) * CHAR_BIT : __builtin_ctz(n);
+#else
+  return detail::ctz(n);
+#endif
+}
+
+template <
+ typename Integer,
+ CONCEPT_REQUIRES_(
+  UnsignedIntegral<Integer>{}
+  and width<Integer> == width<unsigned long> and width<unsigned long> != width<unsigned int>)>
+constexpr int ctz(Integer n) noexcept {
+#if defined(__GNUC__)  // also defined by clang
+  return n == 0 ? sizeof(n) * CHAR_BIT : __builtin_ctzl(n);
+#else
+  return detail::ctz(n);
+#endif
+}
+
+template <
+ typename Integer,
+ CONCEPT_REQUIRES_(
+  UnsignedIntegral<Integer>{}
+  and width<Integer> == width<unsigned long long> and width<unsigned long> != width<unsigned long long>)>
+constexpr int ctz(Integer n) noexcept {
+#if defined(__GNUC__)  // also defined by clang
+  return n == 0 ? sizeof(n) * CHAR_BIT : __builtin_ctzll(n);
+#else
+  return detail::ctz(n);
+#endif
+}
+
+/// Number of set bits of \p n
+constexpr int popcount(uint64_t n) noexcept {
+#if defined(__GNUC__)  // also defined by clang
+  return __builtin_popcountll(n);
+#else
+  int r = 0;
+  for (; n != 0; n &= n - 1) { ++r; }
+  return r;
 #endif
 }
 
+/// Position of the \p k-th (zero-based) set bit of \p n
+///
+/// \pre k < popcount(n)
+constexpr int select(uint64_t n, uint_t k) noexcept {
+  for (; k != 0; --k) { n &= n - 1; }
+  return ctz(n);
+}
+
 #ifdef NDTREE_USE_BMI2
 namespace bmi2_detail {
 
@@ -272,6 +350,103 @@ std::array<UInt, 3> decode(UInt code, std::array<UInt, 3>) noexcept {
 
 }  // namespace morton
 
+/// Hilbert curve utilities
+///
+/// Transformations of the nd-dimensional Hilbert curve following C. Hamilton,
+/// "Compact Hilbert Indices", Technical Report CS-2006-07, Dalhousie
+/// University, 2006.
+///
+/// The curve within a cell is described by its entry point \p e (a corner of
+/// the cell, nd bits) and its intra direction \p d (the dimension along which
+/// the curve leaves the first child, in [0, nd)). The root cell has e = 0 and
+/// d = 0. Children positions in parent are Morton positions (bit i is the
+/// coordinate along dimension i), and the position of a child along the curve
+/// is called its digit.
+namespace hilbert {
+
+/// Rotates the \p nd lowest bits of \p x right by \p r positions
+constexpr uint_t rotate_right(uint_t x, uint_t r, uint_t nd) noexcept {
+  r %= nd;
+  const uint_t mask = (uint_t{1} << nd) - 1;
+  return ((x >> r) | (x << (nd - r))) & mask;
+}
+
+/// Rotates the \p nd lowest bits of \p x left by \p r positions
+constexpr uint_t rotate_left(uint_t x, uint_t r, uint_t nd) noexcept {
+  return rotate_right(x, nd - r % nd, nd);
+}
+
+/// Binary reflected Gray code of \p i
+constexpr uint_t gray_code(uint_t i) noexcept { return i ^ (i >> 1); }
+
+/// Inverse of the binary reflected Gray code
+constexpr uint_t gray_code_inverse(uint_t g) noexcept {
+  uint_t i = 0;
+  for (; g != 0; g >>= 1) { i ^= g; }
+  return i;
+}
+
+/// Number of trailing set bits of \p i
+constexpr uint_t trailing_set_bits(uint_t i) noexcept {
+  uint_t n = 0;
+  for (; i & 1; i >>= 1) { ++n; }
+  return n;
+}
+
+/// Entry point of the child with digit \p w (relative to its parent)
+constexpr uint_t entry_point(uint_t w) noexcept {
+  return w == 0 ? 0 : gray_code(2 * ((w - 1) / 2));
+}
+
+/// Intra direction of the child with digit \p w (relative to its parent)
+constexpr uint_t intra_direction(uint_t w, uint_t nd) noexcept {
+  return w == 0 ? 0 : (w % 2 == 0 ? trailing_set_bits(w - 1) % nd
+                                  : trailing_set_bits(w) % nd);
+}
+
+/// Digit of the child at Morton \p position_in_parent of a cell with entry
+/// point \p e and intra direction \p d
+constexpr uint_t digit(uint_t e, uint_t d, uint_t position_in_parent,
+                       uint_t nd) noexcept {
+  return gray_code_inverse(rotate_right(position_in_parent ^ e, d + 1, nd));
+}
+
+/// Morton position in parent of the child with digit \p w of a cell with entry
+/// point \p e and intra direction \p d
+constexpr uint_t position_in_parent(uint_t e, uint_t d, uint_t w,
+                                    uint_t nd) noexcept {
+  return rotate_left(gray_code(w), d + 1, nd) ^ e;
+}
+
+/// Entry point of the child with digit \p w of a cell with entry point \p e
+/// and intra direction \p d
+constexpr uint_t child_entry_point(uint_t e, uint_t d, uint_t w,
+                                   uint_t nd) noexcept {
+  return e ^ rotate_left(entry_point(w), d + 1, nd);
+}
+
+/// Intra direction of the child with digit \p w of a cell with intra
+/// direction \p d
+constexpr uint_t child_intra_direction(uint_t d, uint_t w, uint_t nd) noexcept {
+  return (d + intra_direction(w, nd) + 1) % nd;
+}
+
+/// Intra direction of the parent of a cell with intra direction \p d and
+/// digit \p w
+constexpr uint_t parent_intra_direction(uint_t d, uint_t w,
+                                        uint_t nd) noexcept {
+  return (d + nd - (intra_direction(w, nd) + 1) % nd) % nd;
+}
+
+/// Entry point of the parent of a cell with entry point \p e and digit \p w,
+/// where \p parent_d is the intra direction of the parent
+constexpr uint_t parent_entry_point(uint_t e, uint_t parent_d, uint_t w,
+                                    uint_t nd) noexcept {
+  return child_entry_point(e, parent_d, w, nd);
+}
+
+}  // namespace hilbert
+
 }  // namespace bit
 }  // namespace v1
 }  // namespace ndtree
@@ -0,0 +1,146 @@
+#pragma once
+/// \file cow_array.hpp Chunked copy-on-write array
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Array whose elements are stored in fixed-size chunks that are shared
+/// between copies and copied only when they are written (copy-on-write)
+///
+/// Copying the array only copies its table of chunk pointers. Writing an
+/// element of a chunk that is shared with another copy first copies that
+/// chunk, so the memory of a set of copies grows with the number of chunks
+/// written after copying.
+///
+/// Different copies can be used from different threads concurrently, but a
+/// copy is not synchronized with writes to itself.
+///
+/// Memory requirements: N elements plus one pointer per ChunkSize elements.
+///
+/// Time complexity: copy O(N / C), read O(1), write O(1) (O(C) if the chunk
+/// is shared), where C is the ChunkSize.
+///
+template <typename T, uint_t ChunkSize = 1024> struct cow_array {
+  static_assert(ChunkSize > 0, "chunks must not be empty");
+
+ private:
+  using chunk = std::array<T, ChunkSize>;
+
+  std::vector<std::shared_ptr<chunk>> chunks_;
+  uint_t size_ = 0;
+
+  /// Chunk containing the element \p i
+  static constexpr uint_t chunk_of(uint_t i) noexcept { return i / ChunkSize; }
+  /// Position of the element \p i within its chunk
+  static constexpr uint_t offset(uint_t i) noexcept { return i % ChunkSize; }
+  /// Number of chunks required to store \p n elements
+  static constexpr uint_t no_chunks(uint_t n) noexcept {
+    return (n + ChunkSize - 1) / ChunkSize;
+  }
+
+  /// Chunk \p c for writing (copied first if it is shared)
+  chunk& mutable_chunk(uint_t c) {
+    auto& p = chunks_[c];
+    if (p.use_count() > 1) {
+      p = std::make_shared<chunk>(*p);
+    } else {
+      // synchronize with the release of the chunk by other copies
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *p;
+  }
+
+ public:
+  using value_type = T;
+
+  cow_array() = default;
+
+  /// Array of \p n copies of \p value
+  cow_array(uint_t n, T value) { resize(n, value); }
+
+  /// Number of elements
+  uint_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+
+  /// Element \p i
+  T const& operator[](uint_t i) const noexcept {
+    NDTREE_ASSERT(i < size(), "index {} is out-of-bounds [0, {})", i, size());
+    return (*chunks_[chunk_of(i)])[offset(i)];
+  }
+
+  /// Sets the element \p i to \p value
+  void set(uint_t i, T value) {
+    NDTREE_ASSERT(i < size(), "index {} is out-of-bounds [0, {})", i, size());
+    if ((*this)[i] == value) { return; }
+    mutable_chunk(chunk_of(i))[offset(i)] = value;
+  }
+
+  /// Last element
+  T const& back() const noexcept {
+    NDTREE_ASSERT(!empty(), "empty array");
+    return (*this)[size() - 1];
+  }
+
+  /// Resizes the array to \p n elements; new elements are set to \p value
+  ///
+  /// The new chunks share a single chunk until they are written.
+  void resize(uint_t n, T value) {
+    if (n <= size_) {
+      chunks_.resize(no_chunks(n));
+      size_ = n;
+      return;
+    }
+    // fill the end of the last chunk:
+    const uint_t e = std::min(n, chunk_count() * ChunkSize);
+    if (e != size_) {
+      auto& c = mutable_chunk(chunk_of(size_));
+      std::fill(c.begin() + offset(size_), c.begin() + offset(e - 1) + 1,
+                value);
+    }
+    if (chunks_.size() != no_chunks(n)) {
+      auto filled = std::make_shared<chunk>();
+      filled->fill(value);
+      chunks_.resize(no_chunks(n), filled);
+    }
+    size_ = n;
+  }
+
+  /// Appends \p value
+  void push_back(T value) { resize(size() + 1, value); }
+
+  /// Removes the last element
+  void pop_back() {
+    NDTREE_ASSERT(!empty(), "empty array");
+    resize(size() - 1, back());
+  }
+
+  /// Number of chunks
+  uint_t chunk_count() const noexcept {
+    return static_cast<uint_t>(chunks_.size());
+  }
+
+  /// Number of chunks at the same position in \p other that are shared
+  /// with this array
+  uint_t shared_chunk_count(cow_array const& other) const noexcept {
+    uint_t r = 0;
+    const auto n = std::min(chunks_.size(), other.chunks_.size());
+    for (std::size_t i = 0; i != n; ++i) {
+      if (chunks_[i] == other.chunks_[i]) { ++r; }
+    }
+    return r;
+  }
+
+  /// Maximum number of elements per chunk
+  static constexpr uint_t chunk_size() noexcept { return ChunkSize; }
+};
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,97 @@
+#pragma once
+/// \file detect.hpp Detection of the optional features of a tree
+#include <type_traits>
+#include <ndtree/types.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Queries of the optional features of a tree (caches, indices, hashes)
+///
+/// Trees that do not provide a feature (e.g. frozen_tree, epoch_tree
+/// snapshots) report it as disabled.
+namespace detect {
+
+namespace impl {
+
+template <typename Tree>
+auto has_level_cache(Tree const& t, int) noexcept
+ -> decltype(t.has_level_cache()) {
+  return t.has_level_cache();
+}
+template <typename Tree>
+bool has_level_cache(Tree const&, long) noexcept {
+  return false;
+}
+
+template <typename Tree>
+auto has_location_cache(Tree const& t, int) noexcept
+ -> decltype(t.has_location_cache()) {
+  return t.has_location_cache();
+}
+template <typename Tree>
+bool has_location_cache(Tree const&, long) noexcept {
+  return false;
+}
+
+template <typename Tree>
+auto has_location_index(Tree const& t, int) noexcept
+ -> decltype(t.has_location_index()) {
+  return t.has_location_index();
+}
+template <typename Tree>
+bool has_location_index(Tree const&, long) noexcept {
+  return false;
+}
+
+template <typename Tree>
+auto has_subtree_hashes(Tree const& t, int) noexcept
+ -> decltype(t.has_subtree_hashes()) {
+  return t.has_subtree_hashes();
+}
+template <typename Tree>
+bool has_subtree_hashes(Tree const&, long) noexcept {
+  return false;
+}
+
+template <typename Loc> Loc to_location(Loc const& l, std::true_type) noexcept {
+  return l;
+}
+template <typename Loc, typename Other>
+Loc to_location(Other const& l, std::false_type) noexcept {
+  return Loc(l());
+}
+
+}  // namespace impl
+
+/// Does the tree \p t store the level of its nodes?
+template <typename Tree> bool has_level_cache(Tree const& t) noexcept {
+  return impl::has_level_cache(t, 0);
+}
+
+/// Does the tree \p t store the location of its nodes?
+template <typename Tree> bool has_location_cache(Tree const& t) noexcept {
+  return impl::has_location_cache(t, 0);
+}
+
+/// Does the tree \p t index the node at each location?
+template <typename Tree> bool has_location_index(Tree const& t) noexcept {
+  return impl::has_location_index(t, 0);
+}
+
+/// Does the tree \p t store the hash of the subtree of each node?
+template <typename Tree> bool has_subtree_hashes(Tree const& t) noexcept {
+  return impl::has_subtree_hashes(t, 0);
+}
+
+/// Converts the location \p l to the location type Loc
+template <typename Loc, typename Other>
+Loc to_location(Other const& l) noexcept {
+  return impl::to_location<Loc>(l, std::is_same<Loc, Other>{});
+}
+
+}  // namespace detect
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,291 @@
+#pragma once
+/// \file hierarchical_bitset.hpp Bitset with fast searches for set bits
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/bit.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Bitset with summary levels for finding set bits in (almost) constant time
+///
+/// Level 0 stores one bit per element. Each bit of level l + 1 is set if the
+/// corresponding word of level l has at least one bit set. The top level
+/// consists of a single word.
+///
+/// Memory requirements: N / 63 words for N bits.
+///
+/// Time complexity of set, reset, find_first, and find_next: O(log_64(N))
+/// (that is, at most 6 levels for 2^32 bits).
+///
+struct hierarchical_bitset {
+  using word_t = std::uint64_t;
+
+ private:
+  /// Number of bits per word
+  static constexpr uint_t word_width = bit::width<word_t>;
+  /// Maximum number of levels (64^11 > 2^64)
+  static constexpr uint_t max_no_levels = 11;
+
+  /// \name Data
+  ///@{
+
+  /// Number of bits in the bitset
+  uint_t size_ = 0;
+  /// Number of levels (0 if the bitset is empty)
+  uint_t no_levels_ = 0;
+  /// Offset of the first word of each level within words_ (the last element
+  /// is the total number of words)
+  std::array<uint_t, max_no_levels + 1> offsets_{{}};
+  /// Words of all levels (level 0 first)
+  std::unique_ptr<word_t[]> words_ = nullptr;
+
+  ///@}  // Data
+
+  /// Number of words required to store \p no_bits bits
+  static constexpr uint_t no_words(uint_t no_bits) noexcept {
+    return (no_bits + word_width - 1) / word_width;
+  }
+
+  /// Number of words at level \p l
+  uint_t no_words_at_level(uint_t l) const noexcept {
+    return offsets_[l + 1] - offsets_[l];
+  }
+
+  /// Number of bits at level \p l
+  uint_t no_bits_at_level(uint_t l) const noexcept {
+    return l == 0 ? size_ : no_words_at_level(l - 1);
+  }
+
+  /// Word \p w of level \p l
+  word_t& word(uint_t l, uint_t w) noexcept {
+    NDTREE_ASSERT(l < no_levels_, "level {} out-of-bounds [0, {})", l,
+                  no_levels_);
+    NDTREE_ASSERT(w < no_words_at_level(l),
+                  "word {} out-of-bounds [0, {}) at level {}", w,
+                  no_words_at_level(l), l);
+    return words_[offsets_[l] + w];
+  }
+  word_t word(uint_t l, uint_t w) const noexcept {
+    NDTREE_ASSERT(l < no_levels_, "level {} out-of-bounds [0, {})", l,
+                  no_levels_);
+    NDTREE_ASSERT(w < no_words_at_level(l),
+                  "word {} out-of-bounds [0, {}) at level {}", w,
+                  no_words_at_level(l), l);
+    return words_[offsets_[l] + w];
+  }
+
+  /// Recomputes the summary levels from level 0
+  void update_summaries() noexcept {
+    for (uint_t l = 1; l < no_levels_; ++l) {
+      const auto n = no_words_at_level(l);
+      for (uint_t w = 0; w < n; ++w) { word(l, w) = word_t{0}; }
+      const auto m = no_words_at_level(l - 1);
+      for (uint_t w = 0; w < m; ++w) {
+        if (word(l - 1, w) != word_t{0}) {
+          word(l, w / word_width) |= word_t{1} << (w % word_width);
+        }
+      }
+    }
+  }
+
+  /// Mask with the bits [0, \p no_bits) set
+  static constexpr word_t low_bits(uint_t no_bits) noexcept {
+    return no_bits == word_width ? ~word_t{0}
+                                 : (word_t{1} << no_bits) - word_t{1};
+  }
+
+ public:
+  /// Number of bits
+  uint_t size() const noexcept { return size_; }
+
+  /// Value of the bit \p i
+  bool test(uint_t i) const noexcept {
+    NDTREE_ASSERT(i < size(), "bit {} out-of-bounds [0, {})", i, size());
+    return bit::get(word(0, i / word_width), i % word_width);
+  }
+
+  /// Sets the bit \p i
+  ///
+  /// \post test(i)
+  void set(uint_t i) noexcept {
+    NDTREE_ASSERT(i < size(), "bit {} out-of-bounds [0, {})", i, size());
+    for (uint_t l = 0, j = i; l < no_levels_; ++l, j /= word_width) {
+      auto& w = word(l, j / word_width);
+      const bool was_empty = w == word_t{0};
+      w |= word_t{1} << (j % word_width);
+      if (!was_empty) { break; }
+    }
+    NDTREE_ASSERT(test(i), "");
+  }
+
+  /// Resets the bit \p i
+  ///
+  /// \post !test(i)
+  void reset(uint_t i) noexcept {
+    NDTREE_ASSERT(i < size(), "bit {} out-of-bounds [0, {})", i, size());
+    for (uint_t l = 0, j = i; l < no_levels_; ++l, j /= word_width) {
+      auto& w = word(l, j / word_width);
+      w &= ~(word_t{1} << (j % word_width));
+      if (w != word_t{0}) { break; }
+    }
+    NDTREE_ASSERT(!test(i), "");
+  }
+
+  /// Resets the bits [\p first, \p last)
+  ///
+  /// Time complexity: O(size() / 64)
+  void reset(uint_t first, uint_t last) noexcept {
+    NDTREE_ASSERT(first <= last and last <= size(),
+                  "bit range [{}, {}) out-of-bounds [0, {})", first, last,
+                  size());
+    for (uint_t i = first; i != last;) {
+      const uint_t w = i / word_width;
+      const uint_t b = i % word_width;
+      const uint_t n = std::min(word_width - b, last - i);
+      word(0, w) &= ~(low_bits(n) << b);
+      i += n;
+    }
+    update_summaries();
+  }
+
+  /// Index of the first set bit at position >= \p i
+  ///
+  /// \returns size() if there is no such bit
+  uint_t find_next(uint_t i) const noexcept {
+    if (i >= size()) { return size(); }
+    // ascend until a word with a set bit at a position >= p is found:
+    uint_t l = 0;
+    uint_t p = i;
+    while (true) {
+      const uint_t w = p / word_width;
+      if (w < no_words_at_level(l)) {
+        const word_t bits = word(l, w) & ~low_bits(p % word_width);
+        if (bits != word_t{0}) {
+          p = w * word_width + static_cast<uint_t>(bit::ctz(bits));
+          break;
+        }
+      }
+      if (l + 1 == no_levels_) { return size(); }
+      ++l;
+      p = w + 1;
+    }
+    // descend to level 0 following the first set bit of each word:
+    while (l > 0) {
+      --l;
+      p = p * word_width + static_cast<uint_t>(bit::ctz(word(l, p)));
+    }
+    NDTREE_ASSERT(p >= i and p < size() and test(p), "");
+    return p;
+  }
+
+  /// Index of the first unset bit at position >= \p i
+  ///
+  /// \returns size() if there is no such bit
+  ///
+  /// Time complexity: O((j - i) / 64), where j is the returned index (the
+  /// summary levels only accelerate searches for set bits).
+  uint_t find_next_unset(uint_t i) const noexcept {
+    if (i >= size()) { return size(); }
+    const uint_t n = no_words_at_level(0);
+    uint_t w = i / word_width;
+    word_t bits = ~word(0, w) & ~low_bits(i % word_width);
+    while (bits == word_t{0}) {
+      if (++w == n) { return size(); }
+      bits = ~word(0, w);
+    }
+    const uint_t p = w * word_width + static_cast<uint_t>(bit::ctz(bits));
+    return std::min(p, size());
+  }
+
+  /// Index of the first set bit
+  ///
+  /// \returns size() if no bit is set
+  uint_t find_first() const noexcept { return find_next(0); }
+
+  /// Are no bits set?
+  bool none() const noexcept {
+    return no_levels_ == 0 or word(no_levels_ - 1, 0) == word_t{0};
+  }
+
+  hierarchical_bitset() = default;
+
+  /// Creates a bitset of \p no_bits bits with all bits set to \p value
+  hierarchical_bitset(uint_t no_bits, bool value = false) : size_(no_bits) {
+    if (no_bits == 0) { return; }
+    // compute the number of words and offsets of each level:
+    uint_t no_bits_l = no_bits;
+    do {
+      NDTREE_ASSERT(no_levels_ < max_no_levels, "too many levels");
+      offsets_[no_levels_ + 1] = offsets_[no_levels_] + no_words(no_bits_l);
+      no_bits_l = no_words(no_bits_l);
+      ++no_levels_;
+    } while (no_bits_l > 1);
+    words_ = std::make_unique<word_t[]>(offsets_[no_levels_]);
+    if (!value) { return; }
+
+    // set all bits (the bits past the end of each level must remain unset):
+    for (uint_t l = 0; l < no_levels_; ++l) {
+      const auto n = no_words_at_level(l);
+      for (uint_t w = 0; w < n; ++w) { word(l, w) = ~word_t{0}; }
+      const auto tail = no_bits_at_level(l) % word_width;
+      if (tail != 0) { word(l, n - 1) = low_bits(tail); }
+    }
+  }
+
+  /// Resizes the bitset to \p no_bits bits
+  ///
+  /// The values of the bits [0, min(size(), no_bits)) are preserved. The
+  /// new bits are set to \p value.
+  ///
+  /// Time complexity: O(no_bits / 64)
+  void resize(uint_t no_bits, bool value = false) {
+    if (no_bits == size()) { return; }
+    hierarchical_bitset other(no_bits, value);
+    if (other.size() > 0 and size() > 0) {
+      const uint_t no_common_bits = std::min(size(), no_bits);
+      const uint_t no_full_words = no_common_bits / word_width;
+      for (uint_t w = 0; w < no_full_words; ++w) {
+        other.word(0, w) = word(0, w);
+      }
+      const auto tail = no_common_bits % word_width;
+      if (tail != 0) {
+        const auto mask = low_bits(tail);
+        auto& ow = other.word(0, no_full_words);
+        ow = (ow & ~mask) | (word(0, no_full_words) & mask);
+      }
+      other.update_summaries();
+    }
+    (*this) = std::move(other);
+  }
+
+  hierarchical_bitset(hierarchical_bitset&&) = default;
+
+  hierarchical_bitset(hierarchical_bitset const& other)
+   : size_(other.size_)
+   , no_levels_(other.no_levels_)
+   , offsets_(other.offsets_)
+   , words_(other.words_
+             ? std::make_unique<word_t[]>(other.offsets_[no_levels_])
+             : nullptr) {
+    std::copy(other.words_.get(), other.words_.get() + offsets_[no_levels_],
+              words_.get());
+  }
+
+  hierarchical_bitset& operator=(hierarchical_bitset other) noexcept {
+    using std::swap;
+    swap(size_, other.size_);
+    swap(no_levels_, other.no_levels_);
+    swap(offsets_, other.offsets_);
+    swap(words_, other.words_);
+    return *this;
+  }
+};
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,165 @@
+#pragma once
+/// \file open_hash_map.hpp Open addressing hash map for integer keys
+#include <algorithm>
+#include <memory>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/bit.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Hash map from non-zero unsigned integer keys to values with open
+/// addressing and linear probing
+///
+/// The key 0 marks empty slots. Erasing uses backward shift deletion, so no
+/// tombstones are needed. The capacity is a power of two and the map grows
+/// when it is half full.
+///
+/// Memory requirements: between 2 and 4 (key, value) pairs per element.
+///
+/// Time complexity of find, insert, and erase: O(1) expected.
+///
+template <typename Key, typename Value> struct open_hash_map {
+  static_assert(UnsignedIntegral<Key>{}, "keys must be unsigned integers");
+
+ private:
+  struct slot {
+    Key key = 0;
+    Value value{};
+  };
+
+  /// Number of elements
+  uint_t size_ = 0;
+  /// Number of slots (0 or a power of two)
+  uint_t capacity_ = 0;
+  std::unique_ptr<slot[]> slots_;
+
+  /// Slot of the key \p k if there are no collisions
+  uint_t home(Key k) const noexcept {
+    std::uint64_t h = static_cast<std::uint64_t>(k) * 0x9E3779B97F4A7C15ull;
+    h ^= h >> 32;
+    return static_cast<uint_t>(h) & (capacity_ - 1);
+  }
+
+  /// Next slot after \p i
+  uint_t next(uint_t i) const noexcept { return (i + 1) & (capacity_ - 1); }
+
+  /// Slot containing the key \p k, or the empty slot where it would be
+  /// inserted
+  uint_t probe(Key k) const noexcept {
+    uint_t i = home(k);
+    while (slots_[i].key != 0 and slots_[i].key != k) { i = next(i); }
+    return i;
+  }
+
+  void rehash(uint_t new_capacity) {
+    auto old = std::move(slots_);
+    const uint_t old_capacity = capacity_;
+    capacity_ = new_capacity;
+    slots_ = std::make_unique<slot[]>(capacity_);
+    for (uint_t i = 0; i != old_capacity; ++i) {
+      if (old[i].key != 0) { slots_[probe(old[i].key)] = old[i]; }
+    }
+  }
+
+ public:
+  open_hash_map() = default;
+
+  /// Map with capacity for at least \p n elements without rehashing
+  explicit open_hash_map(uint_t n) { reserve(n); }
+
+  open_hash_map(open_hash_map&&) = default;
+  open_hash_map& operator=(open_hash_map&&) = default;
+  open_hash_map(open_hash_map const& other)
+   : size_(other.size_), capacity_(other.capacity_) {
+    if (!capacity_) { return; }
+    slots_ = std::make_unique<slot[]>(capacity_);
+    std::copy(other.slots_.get(), other.slots_.get() + capacity_,
+              slots_.get());
+  }
+  open_hash_map& operator=(open_hash_map const& other) {
+    open_hash_map tmp(other);
+    *this = std::move(tmp);
+    return *this;
+  }
+
+  /// Number of elements
+  uint_t size() const noexcept { return size_; }
+
+  /// Is the map empty?
+  bool empty() const noexcept { return size_ == 0; }
+
+  /// Number of slots
+  uint_t capacity() const noexcept { return capacity_; }
+
+  /// Reserves slots for at least \p n elements
+  void reserve(uint_t n) {
+    uint_t c = 16;
+    while (c < 2 * n) { c *= 2; }
+    if (c > capacity_) { rehash(c); }
+  }
+
+  /// Removes all elements
+  void clear() noexcept {
+    std::fill(slots_.get(), slots_.get() + capacity_, slot{});
+    size_ = 0;
+  }
+
+  /// Pointer to the value of the key \p k (nullptr if not found)
+  Value const* find(Key k) const noexcept {
+    NDTREE_ASSERT(k != 0, "the key 0 is reserved");
+    if (!capacity_) { return nullptr; }
+    const uint_t i = probe(k);
+    return slots_[i].key == k ? &slots_[i].value : nullptr;
+  }
+
+  /// Inserts \p k with value \p v, or assigns \p v to the value of \p k if
+  /// \p k is already in the map (assigning never rehashes)
+  void insert_or_assign(Key k, Value v) {
+    NDTREE_ASSERT(k != 0, "the key 0 is reserved");
+    if (capacity_) {
+      const uint_t i = probe(k);
+      if (slots_[i].key == k) {
+        slots_[i].value = v;
+        return;
+      }
+    }
+    if (2 * (size_ + 1) > capacity_) { reserve(size_ + 1); }
+    const uint_t i = probe(k);
+    slots_[i].key = k;
+    slots_[i].value = v;
+    ++size_;
+  }
+
+  /// Erases the key \p k (if it is in the map)
+  ///
+  /// \returns true if the key was erased
+  bool erase(Key k) noexcept {
+    NDTREE_ASSERT(k != 0, "the key 0 is reserved");
+    if (!capacity_) { return false; }
+    uint_t i = probe(k);
+    if (slots_[i].key != k) { return false; }
+    // backward shift deletion: move the following elements of the probe
+    // sequence that are not at their home slot into the hole
+    uint_t j = i;
+    while (true) {
+      j = next(j);
+      if (slots_[j].key == 0) { break; }
+      const uint_t h = home(slots_[j].key);
+      // the element at j can be moved to i if h is not in (i, j] (cyclic):
+      const bool in_range = i <= j ? (i < h and h <= j) : (i < h or h <= j);
+      if (!in_range) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i] = slot{};
+    --size_;
+    return true;
+  }
+};
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,54 @@
+#pragma once
+/// \file parallel_for.hpp Simple thread-based parallel loop
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <ndtree/types.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Number of hardware threads (at least one)
+inline uint_t hardware_concurrency() noexcept {
+  return std::max(uint_t{1},
+                  static_cast<uint_t>(std::thread::hardware_concurrency()));
+}
+
+/// Calls \p f(i) for all i in [\p first, \p last) using \p no_threads threads
+///
+/// The iterations are distributed dynamically in chunks, so iterations with
+/// very different costs (e.g. sub-trees of different sizes) are balanced.
+/// The calling thread participates in the loop. The calls to \p f must not
+/// throw and must be safe to execute concurrently for different i.
+template <typename F>
+void parallel_for(uint_t no_threads, uint_t first, uint_t last, F&& f) {
+  if (last <= first) { return; }
+  const uint_t n = last - first;
+  no_threads = std::max(uint_t{1}, std::min(no_threads, n));
+  if (no_threads == 1) {
+    for (uint_t i = first; i != last; ++i) { f(i); }
+    return;
+  }
+
+  const uint_t chunk_size = std::max(uint_t{1}, n / (8 * no_threads));
+  std::atomic<uint_t> next{first};
+  auto work = [&]() {
+    while (true) {
+      const uint_t b = next.fetch_add(chunk_size);
+      if (b >= last) { return; }
+      const uint_t e = std::min(last, b + chunk_size);
+      for (uint_t i = b; i != e; ++i) { f(i); }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(no_threads - 1);
+  for (uint_t t = 1; t != no_threads; ++t) { threads.emplace_back(work); }
+  work();
+  for (auto&& t : threads) { t.join(); }
+}
+
+}  // namespace v1
+}  // namespace ndtree
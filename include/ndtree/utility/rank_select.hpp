@@ -0,0 +1,152 @@
+#pragma once
+/// \file rank_select.hpp Static bitvector with rank and select support
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/bit.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Immutable bitvector with constant time rank and (almost) constant time
+/// select queries
+///
+/// The bits are grouped into blocks of 8 words (512 bits). For each block
+/// the number of set bits before it is stored (rank directory), and for
+/// every 512-th set bit the block that contains it is stored (select
+/// samples).
+///
+/// Memory requirements: N + N / 8 + 64 N_1 / 512 bits for N bits of which
+/// N_1 are set.
+///
+/// Time complexity: rank O(1), select O(log(B)) where B is the number of
+/// blocks spanned by 512 consecutive set bits (O(1) for dense bitvectors).
+///
+struct rank_select_bitvector {
+  using word_t = std::uint64_t;
+
+ private:
+  /// Number of bits per word
+  static constexpr uint_t word_width = bit::width<word_t>;
+  /// Number of words per block
+  static constexpr uint_t block_words = 8;
+  /// Number of set bits per select sample
+  static constexpr uint_t sample_rate = 512;
+
+  /// \name Data
+  ///@{
+
+  /// Number of bits
+  uint_t size_ = 0;
+  /// Bits: bit i is bit i % 64 of words_[i / 64]
+  std::vector<word_t> words_;
+  /// Number of set bits before each block (the last element is the total
+  /// number of set bits)
+  std::vector<uint_t> block_ranks_;
+  /// Block containing the set bit k * sample_rate, for all k
+  std::vector<uint_t> select_samples_;
+
+  ///@}  // Data
+
+ public:
+  rank_select_bitvector() = default;
+
+  /// Bitvector with the \p no_bits bits stored in \p words
+  ///
+  /// Time complexity: O(N / 64)
+  rank_select_bitvector(std::vector<word_t> words, uint_t no_bits)
+   : size_(no_bits), words_(std::move(words)) {
+    NDTREE_ASSERT(words_.size() * word_width >= size_,
+                  "{} words cannot store {} bits", words_.size(), size_);
+    words_.resize((size_ + word_width - 1) / word_width);
+    // clear the bits past the end:
+    if (size_ % word_width != 0) {
+      words_.back() &= (word_t{1} << (size_ % word_width)) - 1;
+    }
+
+    const uint_t no_blocks = (words_.size() + block_words - 1) / block_words;
+    block_ranks_.resize(no_blocks + 1);
+    uint_t r = 0;
+    for (uint_t b = 0; b != no_blocks; ++b) {
+      block_ranks_[b] = r;
+      const uint_t last = std::min<uint_t>((b + 1) * block_words, words_.size());
+      for (uint_t w = b * block_words; w != last; ++w) {
+        const uint_t c = bit::popcount(words_[w]);
+        // sample the block if it contains the set bits k * sample_rate:
+        for (uint_t k = (r + sample_rate - 1) / sample_rate;
+             k * sample_rate < r + c; ++k) {
+          select_samples_.push_back(b);
+        }
+        r += c;
+      }
+    }
+    block_ranks_[no_blocks] = r;
+  }
+
+  /// Number of bits
+  uint_t size() const noexcept { return size_; }
+
+  /// Number of set bits
+  uint_t count() const noexcept { return block_ranks_.back(); }
+
+  /// Memory used by the bits and the rank and select directories in bytes
+  uint_t memory_usage() const noexcept {
+    return words_.size() * sizeof(word_t)
+           + (block_ranks_.size() + select_samples_.size()) * sizeof(uint_t);
+  }
+
+  /// Is the bit \p i set?
+  bool operator[](uint_t i) const noexcept {
+    NDTREE_ASSERT(i < size(), "bit {} out of bounds [0, {})", i, size());
+    return (words_[i / word_width] >> (i % word_width)) & 1;
+  }
+
+  /// Number of set bits in [0, \p i)
+  ///
+  /// \pre i <= size()
+  uint_t rank1(uint_t i) const noexcept {
+    NDTREE_ASSERT(i <= size(), "rank1({}) out of bounds [0, {}]", i, size());
+    const uint_t w = i / word_width;
+    const uint_t b = w / block_words;
+    uint_t r = block_ranks_[b];
+    for (uint_t j = b * block_words; j != w; ++j) {
+      r += bit::popcount(words_[j]);
+    }
+    if (i % word_width != 0) {
+      r += bit::popcount(words_[w] & ((word_t{1} << (i % word_width)) - 1));
+    }
+    return r;
+  }
+
+  /// Number of unset bits in [0, \p i)
+  uint_t rank0(uint_t i) const noexcept { return i - rank1(i); }
+
+  /// Position of the \p k-th (zero-based) set bit
+  ///
+  /// \pre k < count()
+  uint_t select1(uint_t k) const noexcept {
+    NDTREE_ASSERT(k < count(), "select1({}) out of bounds [0, {})", k,
+                  count());
+    // find the block containing the k-th set bit between the samples:
+    const uint_t s = k / sample_rate;
+    const auto first = block_ranks_.begin() + select_samples_[s];
+    const auto last = s + 1 < select_samples_.size()
+                       ? block_ranks_.begin() + select_samples_[s + 1] + 1
+                       : block_ranks_.end() - 1;
+    const uint_t b = std::upper_bound(first, last, k) - block_ranks_.begin() - 1;
+    // find the word containing the k-th set bit within the block:
+    k -= block_ranks_[b];
+    uint_t w = b * block_words;
+    for (uint_t c = bit::popcount(words_[w]); k >= c;
+         c = bit::popcount(words_[++w])) {
+      k -= c;
+    }
+    return w * word_width + bit::select(words_[w], k);
+  }
+};
+
+}  // namespace v1
+}  // namespace ndtree
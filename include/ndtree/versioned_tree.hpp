@@ -0,0 +1,302 @@
+#pragma once
+/// \file versioned_tree.hpp Persistent tree with copy-on-write versions
+#include <algorithm>
+#include <ndtree/tree.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/cow_array.hpp>
+#include <ndtree/utility/ranges.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// nd-octree whose copies (versions) share their memory
+///
+/// The parent and first child indices are stored in chunked copy-on-write
+/// arrays (see cow_array). Copying the tree takes a snapshot of it: the
+/// chunks are shared between the copies, and are copied only when a
+/// modification of one of the copies writes to them. So a snapshot costs one
+/// pointer per chunk, and the memory of a set of versions grows only with
+/// the chunks modified since they were taken.
+///
+/// The node and sibling group indices of a version are those of the tree
+/// when it was taken. Free sibling groups are reused in LIFO order, and the
+/// tree grows one sibling group at a time, so node indices remain valid
+/// across modifications, like in tree.
+///
+/// Versions implement the read-only tree interface, so the node algorithms
+/// (node_at, node_or_parent_at, node_neighbors, node_location, ...) work on
+/// them. Different versions can be read and modified from different threads
+/// concurrently.
+///
+/// Time complexity: copy O(N / C), where C is the chunk size; refine and
+/// coarsen O(1) (O(C) if they write to a shared chunk).
+///
+template <int nd, typename Index> struct versioned_tree {
+  using tree_t = tree<nd, Index>;
+  using index_t = typename tree_t::index_t;
+  /// Array of indices
+  using indices_t = cow_array<index_t>;
+
+ private:
+  /// Parent of each sibling group
+  indices_t parents_;
+  /// First child of each node
+  indices_t first_children_;
+  /// Stack of free sibling groups
+  indices_t free_;
+  /// Number of nodes in use
+  node_idx size_ = 0_n;
+
+  static constexpr index_t invalid_index() noexcept {
+    return tree_t::invalid_index();
+  }
+
+  /// Number of sibling groups (in use or free)
+  siblings_idx sibling_group_count() const noexcept {
+    return siblings_idx{parents_.size()};
+  }
+
+  /// All non-free sibling group indices in the tree
+  auto sibling_groups() const noexcept {
+    return boxed_ints<siblings_idx>(0_sg, sibling_group_count())
+           | view::filter([&](siblings_idx s) { return !is_free(s); });
+  }
+
+  /// Sibling group for the children of a node
+  ///
+  /// \returns an invalid sibling group if the tree cannot grow further due
+  /// to its index type
+  siblings_idx allocate_sibling_group() {
+    if (!free_.empty()) {
+      const siblings_idx s{static_cast<uint_t>(free_.back())};
+      free_.pop_back();
+      return s;
+    }
+    const auto s = sibling_group_count();
+    if (s == tree_t::max_sibling_group_capacity()) { return siblings_idx{}; }
+    parents_.push_back(invalid_index());
+    first_children_.resize(*tree_t::no_nodes(siblings_idx{*s + 1}),
+                           invalid_index());
+    return s;
+  }
+
+ public:
+  /// Creates a tree with a root node
+  versioned_tree()
+   : parents_(1, invalid_index()), first_children_(1, invalid_index()),
+     size_(1_n) {}
+
+  /// Creates a version of the tree \p t (with the same node indices)
+  ///
+  /// Time complexity: O(N)
+  explicit versioned_tree(tree_t const& t) : size_(t.size()) {
+    const auto no_sgs = t.sibling_group_capacity();
+    parents_.resize(*no_sgs, invalid_index());
+    first_children_.resize(*tree_t::no_nodes(no_sgs), invalid_index());
+    for (uint_t i = 0; i != *no_sgs; ++i) {
+      parents_.set(i, t.raw_parents()[i]);
+    }
+    for (uint_t i = 0; i != first_children_.size(); ++i) {
+      first_children_.set(i, t.raw_first_children()[i]);
+    }
+    for (uint_t i = *no_sgs; i != 0; --i) {
+      if (is_free(siblings_idx{i - 1})) {
+        free_.push_back(static_cast<index_t>(i - 1));
+      }
+    }
+  }
+
+  /// Tree with the nodes of this version (with the same node indices)
+  ///
+  /// Time complexity: O(N)
+  tree_t to_tree() const {
+    const auto no_sgs = sibling_group_count();
+    auto parents = tree_t::make_indices(*no_sgs);
+    auto first_children = tree_t::make_indices(first_children_.size());
+    for (uint_t i = 0; i != *no_sgs; ++i) { parents[i] = parents_[i]; }
+    for (uint_t i = 0; i != first_children_.size(); ++i) {
+      first_children[i] = first_children_[i];
+    }
+    return tree_t(no_sgs, std::move(parents), std::move(first_children));
+  }
+
+  /// \name Spatial constants
+  ///@{
+
+  static constexpr int_t dimension() noexcept { return nd; }
+  static constexpr auto dimensions() noexcept { return tree_t::dimensions(); }
+  static constexpr uint_t no_children() noexcept {
+    return tree_t::no_children();
+  }
+  static constexpr uint_t position_in_parent(node_idx n) noexcept {
+    return tree_t::position_in_parent(n);
+  }
+
+  ///@}  // Spatial constants
+
+  /// \name Graph edges (parent/children)
+  ///@{
+
+  using child_pos = typename tree_t::child_pos;
+
+  static constexpr siblings_idx sibling_group(node_idx n) noexcept {
+    return tree_t::sibling_group(n);
+  }
+  static constexpr bool is_root(node_idx n) noexcept {
+    return tree_t::is_root(n);
+  }
+
+  /// Index of the parent node of the sibling group \p s
+  node_idx parent(siblings_idx s) const noexcept {
+    return tree_t::load(parents_[*s]);
+  }
+
+  /// Index of the parent node of node \p n
+  node_idx parent(node_idx n) const noexcept {
+    return parent(sibling_group(n));
+  }
+
+  /// Index of the first child of node \p n
+  node_idx first_child(node_idx n) const noexcept {
+    return tree_t::load(first_children_[*n]);
+  }
+
+  /// Index of the group of children of node \p n
+  siblings_idx children_group(node_idx n) const noexcept {
+    auto c = first_child(n);
+    return c ? sibling_group(c) : siblings_idx{};
+  }
+
+  /// Range of child positions: [0, no_children)
+  static constexpr auto child_positions() noexcept {
+    return child_pos::rng();
+  }
+
+  /// Child node at position \p p of node \p n
+  node_idx child(node_idx n, child_pos p) const noexcept {
+    const auto fc = first_child(n);
+    return fc ? node_idx{*fc + *p} : fc;
+  }
+
+  /// Range of children nodes of node \p n
+  auto children(node_idx n) const noexcept {
+    const auto fc = first_child(n);
+    return fc ? boxed_ints<node_idx>(*fc, *fc + no_children())
+              : boxed_ints<node_idx>(0_n, 0_n);
+  }
+
+  /// Is node \p n a leaf node?
+  bool is_leaf(node_idx n) const noexcept { return !first_child(n); }
+
+  /// Number of childrens of the node \p n
+  uint_t no_children(node_idx n) const noexcept {
+    return is_leaf(n) ? 0 : no_children();
+  }
+
+  /// Is the sibling group \p s free?
+  bool is_free(siblings_idx s) const noexcept {
+    return *s != 0 and !parent(s);
+  }
+
+  /// Is node \p n part of a free sibling group?
+  bool is_free(node_idx n) const noexcept { return is_free(sibling_group(n)); }
+
+  /// Nodes in sibling group \p s
+  static constexpr auto nodes(siblings_idx s) noexcept {
+    return tree_t::nodes(s);
+  }
+
+  /// All nodes in use within the tree
+  auto nodes() const noexcept {
+    return sibling_groups()
+           | view::transform([](siblings_idx s) { return nodes(s); })
+           | view::join;
+  }
+
+  /// Range filter that selects leaf nodes only
+  auto leaf() const noexcept {
+    return view::filter([&](node_idx i) { return is_leaf(i); });
+  }
+
+  /// Range filter that selects nodes with children only
+  auto with_children() const noexcept {
+    return view::remove_if([&](node_idx i) { return is_leaf(i); });
+  }
+
+  ///@}  // Graph edges
+
+  /// Number of nodes in the tree
+  node_idx size() const noexcept { return size_; }
+
+  /// Number of nodes in use or free
+  node_idx capacity() const noexcept {
+    return node_idx{first_children_.size()};
+  }
+
+  /// \name Modification
+  ///@{
+
+  /// Refines the leaf node \p p
+  ///
+  /// \returns the children group of \p p, or an invalid sibling group if the
+  /// tree cannot grow further due to its index type
+  ///
+  /// \pre !is_free(p) && is_leaf(p)
+  siblings_idx refine(node_idx p) {
+    NDTREE_ASSERT(!is_free(p), "node {} is free", *p);
+    NDTREE_ASSERT(is_leaf(p), "node {} is not a leaf", *p);
+    const auto s = allocate_sibling_group();
+    if (!s) { return s; }
+    parents_.set(*s, tree_t::store(p));
+    first_children_.set(*p, tree_t::store(tree_t::first_node(s)));
+    size_ = node_idx{*size_ + no_children()};
+    return s;
+  }
+
+  /// Coarsens the node \p p
+  ///
+  /// \pre !is_free(p) && all children of \p p are leaves
+  void coarsen(node_idx p) {
+    const auto s = children_group(p);
+    if (!s) { return; }
+    NDTREE_ASSERT(all_of(nodes(s), [&](node_idx c) { return is_leaf(c); }),
+                  "node {}: has non-leaf children", *p);
+    parents_.set(*s, invalid_index());
+    first_children_.set(*p, invalid_index());
+    free_.push_back(static_cast<index_t>(*s));
+    size_ = node_idx{*size_ - no_children()};
+  }
+
+  /// Coarsens the subtree rooted at node \p p
+  ///
+  /// \pre !is_free(p)
+  void coarsen_subtree(node_idx p) {
+    const auto s = children_group(p);
+    if (!s) { return; }
+    RANGES_FOR(auto&& c, nodes(s)) { coarsen_subtree(c); }
+    coarsen(p);
+  }
+
+  ///@}  // Modification
+
+  /// \name Structural sharing
+  ///@{
+
+  /// Number of chunks of the index arrays of this version
+  uint_t chunk_count() const noexcept {
+    return parents_.chunk_count() + first_children_.chunk_count();
+  }
+
+  /// Number of chunks of the index arrays shared with the version \p other
+  uint_t shared_chunk_count(versioned_tree const& other) const noexcept {
+    return parents_.shared_chunk_count(other.parents_)
+           + first_children_.shared_chunk_count(other.first_children_);
+  }
+
+  ///@}  // Structural sharing
+};
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,215 @@
+#pragma once
+/// \file voxel_dag.hpp Sparse voxel DAG: trees with shared identical subtrees
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <ndtree/concepts.hpp>
+#include <ndtree/relations/dimension.hpp>
+#include <ndtree/relations/tree.hpp>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/assert.hpp>
+#include <ndtree/utility/bit.hpp>
+#include <ndtree/utility/bounded.hpp>
+#include <ndtree/utility/ranges.hpp>
+
+namespace ndtree {
+inline namespace v1 {
+//
+
+/// Immutable directed acyclic graph representation of an nd-octree in which
+/// identical subtrees are stored once (sparse voxel DAG)
+///
+/// \tparam nd Number of spatial dimensions
+///
+/// Two leaves are identical if their payload hashes are equal. Two subtrees
+/// are identical if their children are identical. Each unique subtree is a
+/// node of the DAG:
+///
+/// - the internal nodes are [0, no_internal_nodes()), the root is node 0
+///   (unless the tree consists of a single leaf),
+/// - the leaf nodes are [no_internal_nodes(), size()), each one with a
+///   distinct payload hash.
+///
+/// Since nodes have in general multiple parents, only the downward part of
+/// the tree interface is provided (child, children, is_leaf), which suffices
+/// for point queries with node_at and node_or_parent_at.
+///
+/// Memory requirements: 2^nd indices per internal DAG node plus one hash per
+/// leaf DAG node.
+template <int nd> struct voxel_dag {
+  /// Number of children per node
+  static constexpr uint_t no_children() noexcept {
+    return ndtree::no_children(nd);
+  }
+
+ private:
+  /// Children of the internal nodes (no_children() indices per node)
+  std::vector<uint_t> children_;
+  /// Payload hash of each leaf node
+  std::vector<std::uint64_t> leaf_hashes_;
+
+  using children_t = std::array<uint_t, no_children()>;
+
+  struct children_hash {
+    std::size_t operator()(children_t const& cs) const noexcept {
+      std::uint64_t h = 0x9E3779B97F4A7C15ull;
+      for (auto c : cs) { h = (h ^ c) * 0xFF51AFD7ED558CCDull; }
+      return static_cast<std::size_t>(h ^ (h >> 32));
+    }
+  };
+
+  /// State of the builder
+  struct builder {
+    /// Children of each internal node (in creation order)
+    std::vector<children_t> internal;
+    /// Payload hash of each leaf node (in creation order)
+    std::vector<std::uint64_t> leaves;
+    std::unordered_map<children_t, uint_t, children_hash> internal_ids;
+    std::unordered_map<std::uint64_t, uint_t> leaf_ids;
+  };
+
+  /// Builds the DAG node of the subtree of \p t rooted at \p n
+  ///
+  /// \returns the index of the node within builder::internal, or, for leaves,
+  /// the index within builder::leaves with the most significant bit set
+  template <typename Tree, typename LeafHash>
+  static uint_t build(builder& b, Tree const& t, node_idx n, LeafHash& h) {
+    constexpr uint_t leaf_bit = uint_t{1} << (bit::width<uint_t> - 1);
+    if (t.is_leaf(n)) {
+      const std::uint64_t v = h(n);
+      auto it = b.leaf_ids.find(v);
+      if (it != b.leaf_ids.end()) { return it->second | leaf_bit; }
+      const uint_t id = b.leaves.size();
+      b.leaves.push_back(v);
+      b.leaf_ids.emplace(v, id);
+      return id | leaf_bit;
+    }
+    children_t cs;
+    uint_t i = 0;
+    RANGES_FOR(auto&& c, t.children(n)) { cs[i++] = build(b, t, c, h); }
+    auto it = b.internal_ids.find(cs);
+    if (it != b.internal_ids.end()) { return it->second; }
+    const uint_t id = b.internal.size();
+    b.internal.push_back(cs);
+    b.internal_ids.emplace(cs, id);
+    return id;
+  }
+
+  struct zero_hash {
+    template <typename T> std::uint64_t operator()(T&&) const noexcept {
+      return 0;
+    }
+  };
+
+ public:
+  /// Number of spatial dimensions of the tree
+  static constexpr int_t dimension() noexcept { return nd; }
+
+  /// Range of spatial dimensions of the tree: [0, nd)
+  static constexpr auto dimensions() noexcept {
+    return ndtree::dimensions(dimension());
+  }
+
+  /// Child position type is a uint_t bounded in [0, no_children)
+  using child_pos = bounded<uint_t, 0, no_children(), struct child_pos_tag>;
+
+  /// Range of child positions: [0, no_children)
+  static constexpr auto child_positions() noexcept { return child_pos::rng(); }
+
+  /// Number of internal nodes
+  uint_t no_internal_nodes() const noexcept {
+    return children_.size() / no_children();
+  }
+
+  /// Number of leaf nodes (that is, of distinct leaf payload hashes)
+  uint_t no_leaf_nodes() const noexcept { return leaf_hashes_.size(); }
+
+  /// Number of nodes
+  node_idx size() const noexcept {
+    return node_idx{no_internal_nodes() + no_leaf_nodes()};
+  }
+
+  /// Is the DAG empty?
+  bool empty() const noexcept { return size() == 0_n; }
+
+  /// Is \p n the root node?
+  static constexpr bool is_root(node_idx n) noexcept { return *n == 0; }
+
+  /// Is node \p n a leaf node?
+  bool is_leaf(node_idx n) const noexcept {
+    NDTREE_ASSERT(n < size(), "node {} is out-of-bounds [0, {})", n, size());
+    return *n >= no_internal_nodes();
+  }
+
+  /// Payload hash of the leaf node \p n
+  ///
+  /// \pre is_leaf(n)
+  std::uint64_t leaf_hash(node_idx n) const noexcept {
+    NDTREE_ASSERT(is_leaf(n), "node {} is not a leaf", n);
+    return leaf_hashes_[*n - no_internal_nodes()];
+  }
+
+  /// Child node at position \p p of node \p n (invalid if \p n is a leaf)
+  node_idx child(node_idx n, child_pos p) const noexcept {
+    return is_leaf(n) ? node_idx{}
+                      : node_idx{children_[*n * no_children() + *p]};
+  }
+
+  /// Range of children nodes of node \p n
+  auto children(node_idx n) const noexcept {
+    const uint_t k = is_leaf(n) ? 0 : no_children();
+    return view::counted(children_.data() + (k ? *n * k : 0), k)
+           | view::transform([](uint_t c) { return node_idx{c}; });
+  }
+
+  /// Memory used by the nodes in bytes
+  uint_t memory_usage() const noexcept {
+    return children_.size() * sizeof(uint_t)
+           + leaf_hashes_.size() * sizeof(std::uint64_t);
+  }
+
+  voxel_dag() = default;
+
+  /// Builds the DAG of the tree \p t
+  ///
+  /// \param t [in] Tree.
+  /// \param leaf_hash [in] Function (node_idx) -> std::uint64_t returning the
+  ///                       payload hash of a leaf node of \p t (by default all
+  ///                       leaves are identical, that is, only the structure
+  ///                       of the tree is stored).
+  ///
+  /// \pre !t.empty()
+  ///
+  /// Time complexity: O(N) expected.
+  template <typename Tree, typename LeafHash = zero_hash,
+            CONCEPT_REQUIRES_(Tree::dimension() == nd)>
+  explicit voxel_dag(Tree const& t, LeafHash leaf_hash = LeafHash{}) {
+    NDTREE_ASSERT(!t.empty(), "cannot build the DAG of an empty tree");
+    builder b;
+    const uint_t root = build(b, t, 0_n, leaf_hash);
+    NDTREE_ASSERT(b.internal.empty() or root == b.internal.size() - 1,
+                  "the root must be the last internal node created");
+    (void)root;
+
+    // Internal nodes are created bottom-up, so number them in reverse
+    // creation order (the root becomes node 0) followed by the leaves:
+    const uint_t no_internal = b.internal.size();
+    constexpr uint_t leaf_bit = uint_t{1} << (bit::width<uint_t> - 1);
+    auto id = [&](uint_t i) {
+      return (i & leaf_bit) ? no_internal + (i & ~leaf_bit)
+                            : no_internal - 1 - i;
+    };
+    children_.resize(no_internal * no_children());
+    for (uint_t i = 0; i != no_internal; ++i) {
+      const uint_t n = no_internal - 1 - i;
+      for (uint_t c = 0; c != no_children(); ++c) {
+        children_[n * no_children() + c] = id(b.internal[i][c]);
+      }
+    }
+    leaf_hashes_ = std::move(b.leaves);
+  }
+};
+
+}  // namespace v1
+}  // namespace ndtree
@@ -0,0 +1,95 @@
+/// \file concurrent_refinement.cpp Lock-free concurrent refinement tests
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <ndtree/concurrent_refinement.hpp>
+#include "test.hpp"
+#include "tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+/// Refines the subtree of \p n until \p level
+template <typename Refinement>
+void refine_until(Refinement& r, node_idx n, uint_t l, uint_t level) {
+  if (l == level) { return; }
+  const auto s = r.refine(n);
+  CHECK(s);
+  CHECK(r.children_group(n) == s);
+  RANGES_FOR(auto&& c, Refinement::tree_t::nodes(s)) {
+    CHECK(r.parent(c) == n);
+    refine_until(r, c, l + 1, level);
+  }
+}
+
+/// Each thread refines the subtree of one child of the root until \p level
+template <int nd> void test_concurrent_refinement(uint_t level) {
+  tree<nd> t(1);
+  t.enable_level_cache();
+  t.enable_location_index();
+  const auto s = t.refine(0_n);
+  auto expected = uniformly_refined_tree<nd>(level, level);
+  const uint_t no_refined = (*expected.size() - *t.size()) / t.no_children();
+  {
+    concurrent_refinement<tree<nd>> r(t, no_refined);
+    std::vector<std::thread> threads;
+    RANGES_FOR(auto&& c, tree<nd>::nodes(s)) {
+      threads.emplace_back([&r, c, level]() { refine_until(r, c, 1, level); });
+    }
+    for (auto&& th : threads) { th.join(); }
+    CHECK(r.finish() == no_refined);
+  }
+  CHECK(t.size() == expected.size());
+  CHECK(t.is_compact());
+  RANGES_FOR(auto&& n, t.nodes()) {
+    CHECK(t.level(n) == t.location(n).level());
+    CHECK(node_at(t, t.location(n)) == n);
+  }
+  dfs_sort(t);
+  dfs_sort(expected);
+  CHECK(t == expected);
+}
+
+/// Threads racing to refine the same node: only one succeeds
+void test_same_node() {
+  tree<2> t(1);
+  t.refine(0_n);
+  t.refine(2_n);
+  t.coarsen(2_n);  // leaves a free sibling group before the end
+  {
+    concurrent_refinement<tree<2>> r(t, 8);
+    std::atomic<uint_t> no_refined{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i != 8; ++i) {
+      threads.emplace_back([&]() {
+        if (r.refine(3_n)) { ++no_refined; }
+      });
+    }
+    for (auto&& th : threads) { th.join(); }
+    CHECK(no_refined.load() == 1_u);
+    CHECK(!r.is_leaf(3_n));
+    CHECK(r.finish() == 1_u);
+  }
+  CHECK(t.size() == 9_n);
+  CHECK(!t.is_leaf(3_n));
+
+  {  // at most max_no_refined nodes are refined
+    concurrent_refinement<tree<2>> r(t, 2);
+    CHECK(r.refine(1_n));
+    CHECK(r.refine(2_n));
+    CHECK(!r.refine(4_n));
+  }
+  CHECK(t.size() == 17_n);
+  CHECK(!t.is_leaf(1_n));
+  CHECK(!t.is_leaf(2_n));
+  CHECK(t.is_leaf(4_n));
+}
+
+int main() {
+  test_concurrent_refinement<1>(8);
+  test_concurrent_refinement<2>(5);
+  test_concurrent_refinement<3>(4);
+  test_same_node();
+
+  return test::result();
+}
@@ -0,0 +1,125 @@
+/// \file concurrent_tree.cpp Concurrent tree tests
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <ndtree/concurrent_tree.hpp>
+#include "test.hpp"
+#include "tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+/// Refines the subtree of \p n until \p level
+template <int nd>
+void refine_until(concurrent_tree<nd>& t, node_idx n, uint_t l, uint_t level) {
+  if (l == level) { return; }
+  const auto s = t.refine(n);
+  CHECK(s);
+  RANGES_FOR(auto&& c, tree<nd>::nodes(s)) { refine_until(t, c, l + 1, level); }
+}
+
+/// Coarsens the subtree of \p n bottom-up, one node at a time
+template <int nd> void coarsen_bottom_up(concurrent_tree<nd>& t, node_idx n) {
+  const auto s = t.children_group(n);
+  if (!s) { return; }
+  RANGES_FOR(auto&& c, tree<nd>::nodes(s)) { coarsen_bottom_up(t, c); }
+  CHECK(t.coarsen(n));
+}
+
+/// Each thread refines the subtree of one child of the root until \p level
+/// (the tree grows concurrently), and then coarsens it again
+template <int nd> void test_concurrent_tree(uint_t level) {
+  concurrent_tree<nd> t(1, 4);
+  const auto s = t.refine(0_n);
+  CHECK(s == 1_sg);
+
+  std::vector<std::thread> threads;
+  RANGES_FOR(auto&& c, tree<nd>::nodes(s)) {
+    threads.emplace_back([&t, c, level]() { refine_until(t, c, 1, level); });
+  }
+  for (auto&& th : threads) { th.join(); }
+  threads.clear();
+
+  auto u = t.underlying();
+  auto expected = uniformly_refined_tree<nd>(level, level);
+  CHECK(u.size() == expected.size());
+  dfs_sort(u);
+  dfs_sort(expected);
+  CHECK(u == expected);
+
+  RANGES_FOR(auto&& c, tree<nd>::nodes(s)) {
+    threads.emplace_back([&t, c]() { coarsen_bottom_up(t, c); });
+  }
+  for (auto&& th : threads) { th.join(); }
+  CHECK(t.size() == 1_n + tree<nd>::no_children());
+  RANGES_FOR(auto&& c, tree<nd>::nodes(s)) { CHECK(t.is_leaf(c)); }
+}
+
+/// Threads racing to refine or coarsen the same node: only one succeeds
+void test_same_node() {
+  concurrent_tree<2> t(1);
+  t.refine(0_n);
+  std::atomic<uint_t> no_refined{0}, no_coarsened{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i != 8; ++i) {
+    threads.emplace_back([&]() {
+      if (t.refine(3_n)) { ++no_refined; }
+    });
+  }
+  for (auto&& th : threads) { th.join(); }
+  threads.clear();
+  CHECK(no_refined.load() == 1_u);
+  CHECK(t.size() == 9_n);
+
+  for (int i = 0; i != 8; ++i) {
+    threads.emplace_back([&]() {
+      if (t.coarsen(3_n)) { ++no_coarsened; }
+    });
+  }
+  for (auto&& th : threads) { th.join(); }
+  CHECK(no_coarsened.load() == 1_u);
+  CHECK(t.size() == 5_n);
+
+  // nodes with non-leaf children are not coarsened:
+  t.refine(3_n);
+  CHECK(!t.coarsen(0_n));
+  t.coarsen_subtree(0_n);
+  CHECK(t.size() == 1_n);
+}
+
+/// size() is consistent while another thread coarsens subtrees
+void test_size_while_coarsening() {
+  concurrent_tree<2> t(1);
+  t.refine(0_n);
+  refine_until(t, 1_n, 1, 4);
+  const auto max_size = *t.size();
+  t.coarsen_subtree(1_n);
+  CHECK(t.size() == 5_n);
+
+  std::atomic<bool> done{false};
+  std::thread poller([&]() {
+    while (!done) {
+      const auto n = *t.size();
+      CHECK(n >= 5_u);
+      CHECK(n <= max_size);
+      CHECK(((n - 1) % tree<2>::no_children()) == 0_u);
+    }
+  });
+  for (int i = 0; i != 100; ++i) {
+    refine_until(t, 1_n, 1, 4);
+    t.coarsen_subtree(1_n);
+  }
+  done = true;
+  poller.join();
+  CHECK(t.size() == 5_n);
+}
+
+int main() {
+  test_concurrent_tree<1>(8);
+  test_concurrent_tree<2>(5);
+  test_concurrent_tree<3>(4);
+  test_same_node();
+  test_size_while_coarsening();
+
+  return test::result();
+}
@@ -0,0 +1,84 @@
+/// \file diff.cpp Tree diff and patch tests
+#include <random>
+#include <vector>
+#include <ndtree/versioned_tree.hpp>
+#include "test.hpp"
+#include "tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+/// Checks that the trees \p a and \p b have the same nodes (their node
+/// indices can differ)
+template <int nd> void check_same_nodes(tree<nd> a, tree<nd> b) {
+  dfs_sort(a);
+  dfs_sort(b);
+  CHECK(a == b);
+}
+
+/// Randomly refines and coarsens the tree \p t \p m times
+template <typename Tree> void modify(Tree& t, uint_t m, std::mt19937& gen) {
+  for (uint_t i = 0; i != m; ++i) {
+    std::vector<node_idx> ns;
+    RANGES_FOR(auto&& n, t.nodes()) { ns.push_back(n); }
+    const auto n = ns[gen() % ns.size()];
+    if (t.is_leaf(n)) {
+      if (node_level(t, n) < 6) { t.refine(n); }
+    } else {
+      t.coarsen_subtree(n);
+    }
+  }
+}
+
+template <int nd> void test_diff() {
+  std::mt19937 gen(nd);
+  const auto t0 = uniformly_refined_tree<nd>(2, 2);
+  CHECK(diff(t0, t0).empty());
+
+  {  // one refinement and one coarsening
+    auto t1 = t0;
+    const auto a = t1.child(0_n, typename tree<nd>::child_pos{0});
+    const auto b = t1.child(0_n, typename tree<nd>::child_pos{1});
+    t1.refine(t1.child(a, typename tree<nd>::child_pos{1}));
+    t1.coarsen_subtree(b);
+    const auto p = diff(t0, t1);
+    CHECK(p.refined.size() == 1_u);
+    CHECK(p.coarsened.size() == 1_u);
+    auto r = t0;
+    apply(r, p);
+    check_same_nodes(r, t1);
+    // the inverse patch:
+    apply(r, diff(t1, t0));
+    check_same_nodes(r, t0);
+  }
+
+  {  // replicas follow a sequence of random modifications
+    auto t = t0;
+    auto replica = t0;
+    for (int i = 0; i != 20; ++i) {
+      const auto before = t;
+      modify(t, 10, gen);
+      const auto p = diff(before, t);
+      apply(replica, p);
+      check_same_nodes(replica, t);
+    }
+  }
+
+  {  // between different tree types
+    versioned_tree<nd> v(t0);
+    auto t1 = t0;
+    modify(v, 20, gen);
+    apply(t1, diff(t0, v));
+    check_same_nodes(t1, v.to_tree());
+    apply(v, diff(v, t0));
+    CHECK(diff(v, t0).empty());
+  }
+}
+
+int main() {
+  test_diff<1>();
+  test_diff<2>();
+  test_diff<3>();
+
+  return test::result();
+}
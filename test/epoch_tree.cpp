@@ -0,0 +1,143 @@
+/// \file epoch_tree.cpp Epoch-based snapshot tests
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <ndtree/epoch_tree.hpp>
+#include "test.hpp"
+#include "tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+/// Checks that the snapshot \p s shows the same tree as \p t (with the same
+/// node indices)
+template <typename Snapshot, typename Loc = location::default_location<2>>
+void check_snapshot(Snapshot const& s, tree<2> const& t) {
+  RANGES_FOR(auto&& n, t.nodes()) {
+    CHECK(s.is_leaf(n) == t.is_leaf(n));
+    CHECK(s.children_group(n) == t.children_group(n));
+    if (!t.is_root(n)) { CHECK(s.parent(n) == t.parent(n)); }
+    const auto loc = node_location(t, n, Loc{});
+    CHECK(node_location(s, n, Loc{}) == loc);
+    CHECK(node_at(s, loc) == n);
+    CHECK(ranges::equal(node_neighbors(s, loc), node_neighbors(t, loc)));
+  }
+}
+
+/// Level of the smallest node containing each leaf location of \p t
+template <typename Tree, typename Loc = location::default_location<2>>
+void check_same_leaves(Tree const& s, tree<2> const& t) {
+  RANGES_FOR(auto&& n, t.nodes() | t.leaf()) {
+    const auto loc = node_location(t, n, Loc{});
+    auto r = node_or_parent_at(s, loc);
+    CHECK(r.level == loc.level());
+    CHECK(s.is_leaf(r.idx));
+  }
+}
+
+void test_snapshots() {
+  const auto t0 = uniformly_refined_tree<2>(3, 3);
+  epoch_tree<2> t(t0);
+  CHECK(t.epoch() == 0_u);
+
+  auto s0 = t.pin();
+  check_snapshot(s0, t0);
+
+  // modify: the pinned snapshot does not change
+  const auto a = node_at(t0, location::slim<2>({0}));
+  const auto b = node_at(t0, location::slim<2>({3, 3, 3}));
+  const auto c = node_at(t0, location::slim<2>({2, 1}));
+  auto t1 = t0;
+  t.coarsen_subtree(a);
+  t1.coarsen_subtree(a);
+  t.refine(b);
+  t1.refine(b);
+  t.coarsen(c);
+  t1.coarsen(c);
+  CHECK(t.epoch() >= 3_u);  // growing the tree also advances the epoch
+  CHECK(s0.epoch() == 0_u);
+  CHECK(t.size() == t1.size());
+  check_snapshot(s0, t0);
+
+  // the retired sibling groups are not reused while s0 is pinned:
+  CHECK(t.underlying().size() > t1.size());
+
+  // new snapshots see the modifications:
+  {
+    auto s1 = t.pin();
+    CHECK(s1.epoch() == t.epoch());
+    check_same_leaves(s1, t1);
+    check_snapshot(s0, t0);
+  }
+
+  // releasing s0 allows reclaiming the retired groups:
+  s0.release();
+  t.synchronize();
+  CHECK(t.underlying().size() == t1.size());
+  check_same_leaves(t.pin(), t1);
+
+  // refining a node whose children were retired reuses memory:
+  t.refine(a);
+  t1.refine(a);
+  check_same_leaves(t.pin(), t1);
+}
+
+void test_growth() {
+  epoch_tree<2> t(1);
+  auto s0 = t.pin();
+  tree<2> t0(1);
+  tree<2> t1(1);
+  // grows the tree several times while s0 is pinned:
+  for (auto n : {0_n, 1_n, 5_n, 9_n, 13_n}) {
+    t.refine(n);
+    t1.refine(n);
+  }
+  check_snapshot(s0, t0);
+  check_same_leaves(t.pin(), t1);
+}
+
+/// A writer refines and coarsens a node while readers query it: each
+/// snapshot sees it either refined or coarsened, but never changing
+void test_concurrent_readers() {
+  using loc_t = location::default_location<2>;
+  epoch_tree<2> t(uniformly_refined_tree<2>(2, 2), 4);
+  const auto n = node_at(t.underlying(), location::slim<2>({1, 2}));
+  auto loc = node_location(t.underlying(), n, loc_t{});
+  loc.push(1);
+  loc.push(2);
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i != 4; ++i) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        auto s = t.pin();
+        const auto r = node_or_parent_at(s, loc);
+        CHECK((r.level == 2_u or r.level == 3_u or r.level == 4_u));
+        for (int j = 0; j != 10; ++j) {
+          CHECK(node_or_parent_at(s, loc).level == r.level);
+          CHECK(node_or_parent_at(s, loc).idx == r.idx);
+        }
+      }
+    });
+  }
+
+  for (int i = 0; i != 1000; ++i) {
+    t.refine(n);
+    t.refine(t.underlying().child(n, tree<2>::child_pos{1}));
+    t.coarsen_subtree(n);
+  }
+  done = true;
+  for (auto&& th : readers) { th.join(); }
+  t.synchronize();
+  CHECK(t.size() == 21_n);
+  CHECK(t.underlying().size() == 21_n);
+}
+
+int main() {
+  test_snapshots();
+  test_growth();
+  test_concurrent_readers();
+
+  return test::result();
+}
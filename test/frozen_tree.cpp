@@ -0,0 +1,76 @@
+/// \file frozen_tree.cpp Frozen (LOUDS) tree tests
+#include <ndtree/frozen_tree.hpp>
+#include "test.hpp"
+#include "tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+/// Checks that the frozen tree \p f equals the tree \p t after bfs_sort and
+/// that the algorithms return the same results on both
+template <int nd, typename Loc = location::default_location<nd>>
+void check_frozen(tree<nd> t) {
+  frozen_tree<nd> f(t);
+  bfs_sort(t);
+  CHECK(f.size() == t.size());
+  CHECK(f.sibling_group_capacity() == t.sibling_group(t.size()));
+  RANGES_FOR(auto&& n, t.nodes()) {
+    CHECK(f.parent(n) == t.parent(n));
+    CHECK(f.is_leaf(n) == t.is_leaf(n));
+    CHECK(f.children_group(n) == t.children_group(n));
+    CHECK(ranges::equal(f.children(n), t.children(n)));
+    const auto loc = node_location(t, n, Loc{});
+    CHECK(node_location(f, n, Loc{}) == loc);
+    CHECK(node_at(f, loc) == n);
+    CHECK(node_level(f, n) == node_level(t, n));
+    CHECK(ranges::equal(node_neighbors(f, loc), node_neighbors(t, loc)));
+  }
+  CHECK(ranges::distance(f.nodes() | f.leaf())
+        == ranges::distance(t.nodes() | t.leaf()));
+}
+
+int main() {
+  {  // root only
+    frozen_tree<2> f(tree<2>(1));
+    CHECK(f.size() == 1_n);
+    CHECK(f.is_leaf(0_n));
+    CHECK(!f.parent(0_n));
+    CHECK(!f.child(0_n, frozen_tree<2>::child_pos{0}));
+  }
+  {  // small tree
+    tree<2> t(1);
+    t.refine(0_n);
+    t.refine(3_n);
+    t.refine(1_n);
+    frozen_tree<2> f(t);
+    CHECK(f.size() == 13_n);
+    test::check_equal(f.children(0_n), {1_n, 2_n, 3_n, 4_n});
+    test::check_equal(f.children(1_n), {5_n, 6_n, 7_n, 8_n});
+    test::check_equal(f.children(3_n), {9_n, 10_n, 11_n, 12_n});
+    CHECK(f.is_leaf(2_n));
+    CHECK(f.parent(7_n) == 1_n);
+    CHECK(f.parent(12_n) == 3_n);
+    check_frozen(t);
+  }
+  {  // unsorted trees with holes
+    auto t = uniformly_refined_tree<2>(5, 5);
+    t.coarsen_subtree(2_n);
+    t.refine(first_leaf(t));
+    check_frozen(t);
+
+    // less than 2 bits per node:
+    frozen_tree<2> f(t);
+    CHECK((f.memory_usage() * 8) < 2 * *f.size());
+
+    auto t1 = uniformly_refined_tree<1>(6, 6);
+    t1.coarsen_subtree(3_n);
+    check_frozen(t1);
+
+    auto t3 = uniformly_refined_tree<3>(3, 3);
+    t3.coarsen_subtree(9_n);
+    t3.refine(first_leaf(t3));
+    check_frozen(t3);
+  }
+
+  return test::result();
+}
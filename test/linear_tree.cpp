@@ -0,0 +1,130 @@
+/// \file linear_tree.cpp Linear tree tests
+#include <ndtree/linear_tree.hpp>
+#include "test.hpp"
+#include "tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+/// Are the leaves \p a and \p b of \p t adjacent? (brute force)
+template <typename LinearTree>
+bool adjacent(LinearTree const& t, node_idx a, node_idx b) {
+  using loc_t = typename LinearTree::location_t;
+  using int_t_ = typename LinearTree::integer_t;
+  constexpr int nd = LinearTree::dimension();
+  const auto la = t[a];
+  const auto lb = t[b];
+  const auto xa = static_cast<std::array<int_t_, nd>>(la);
+  const auto xb = static_cast<std::array<int_t_, nd>>(lb);
+  const uint_t sa = loc_t::max_level() - la.level();
+  const uint_t sb = loc_t::max_level() - lb.level();
+  bool touch = true;
+  bool overlap = true;
+  for (auto&& d : dimensions(nd)) {
+    const int_t_ a0 = xa[d] << sa, a1 = a0 + (int_t_{1} << sa);
+    const int_t_ b0 = xb[d] << sb, b1 = b0 + (int_t_{1} << sb);
+    touch = touch and b1 >= a0 and b0 <= a1;
+    overlap = overlap and b1 > a0 and b0 < a1;
+  }
+  return touch and !overlap;
+}
+
+/// Checks the linear tree \p lt against the tree \p t
+template <int nd> void check_linear_tree(tree<nd> const& t) {
+  using lt_t = linear_tree<nd>;
+  using loc_t = typename lt_t::location_t;
+  lt_t lt(t);
+  CHECK(lt.size() == ranges::distance(t.nodes() | t.leaf()));
+  CHECK(std::is_sorted(lt.leaves().begin(), lt.leaves().end(),
+                       [](loc_t a, loc_t b) {
+                         return a.value << (nd * (loc_t::max_level() - a.level()))
+                                < b.value
+                                   << (nd * (loc_t::max_level() - b.level()));
+                       }));
+
+  RANGES_FOR(auto&& n, t.nodes()) {
+    auto loc = node_location(t, n, loc_t{});
+    const auto r = node_or_parent_at(t, loc);
+    const auto rl = lt.node_or_parent_at(loc);
+    CHECK(rl.level == r.level);
+    CHECK(static_cast<bool>(rl.idx) == t.is_leaf(n));
+    if (t.is_leaf(n)) {
+      CHECK(lt[rl.idx] == loc);
+      CHECK(lt.node_at(loc) == rl.idx);
+      loc.push(1);  // locations below a leaf are within the leaf
+      CHECK(lt.node_or_parent_at(loc).idx == rl.idx);
+      CHECK(!lt.node_at(loc));
+    } else {
+      CHECK(!lt.node_at(loc));
+    }
+  }
+
+  for (uint_t i = 0; i != lt.size(); ++i) {
+    const auto ns = lt.neighbors(node_idx{i});
+    for (uint_t j = 0; j != lt.size(); ++j) {
+      if (i == j) { continue; }
+      const bool found
+       = std::find(ns.begin(), ns.end(), node_idx{j}) != ns.end();
+      CHECK(found == adjacent(lt, node_idx{i}, node_idx{j}));
+    }
+  }
+}
+
+int main() {
+  {  // root only
+    linear_tree<2> lt;
+    CHECK(lt.size() == 1_u);
+    CHECK(lt.neighbors(0_n).empty());
+    CHECK(lt == linear_tree<2>(tree<2>(1)));
+  }
+  {  // refine and coarsen by merging
+    tree<2> t(1);
+    linear_tree<2> lt;
+    t.refine(0_n);
+    lt.refine(0_n);
+    CHECK(lt == linear_tree<2>(t));
+    t.refine(std::vector<node_idx>{1_n, 4_n});
+    lt.refine(std::vector<node_idx>{0_n, 3_n});
+    CHECK(lt.size() == 10_u);
+    CHECK(lt == linear_tree<2>(t));
+    check_linear_tree(t);
+
+    // refine the leaves at locations {0, 3} and {3, 0}:
+    using loc_t = linear_tree<2>::location_t;
+    loc_t l03, l30;
+    l03.push(0);
+    l03.push(3);
+    l30.push(3);
+    l30.push(0);
+    lt.refine(std::vector<node_idx>{lt.node_at(l30), lt.node_at(l03)});
+    t.refine(std::vector<node_idx>{node_at(t, l03), node_at(t, l30)});
+    CHECK(lt == linear_tree<2>(t));
+    check_linear_tree(t);
+
+    // coarsen (nested nodes and leaves are skipped):
+    loc_t l0;
+    l0.push(0);
+    lt.coarsen(std::vector<loc_t>{l03, l30, l0});
+    t.coarsen(std::vector<node_idx>{node_at(t, l0), node_at(t, l30)});
+    CHECK(lt == linear_tree<2>(t));
+    lt.coarsen(loc_t{});
+    CHECK(lt == linear_tree<2>());
+  }
+  {  // larger trees
+    auto t = uniformly_refined_tree<2>(3, 4);
+    t.coarsen_subtree(2_n);
+    t.refine(first_leaf(t));
+    t.refine(first_leaf(t));
+    check_linear_tree(t);
+
+    auto t1 = uniformly_refined_tree<1>(4, 5);
+    t1.refine(first_leaf(t1));
+    check_linear_tree(t1);
+
+    auto t3 = uniformly_refined_tree<3>(2, 3);
+    t3.refine(first_leaf(t3));
+    check_linear_tree(t3);
+  }
+
+  return test::result();
+}
@@ -0,0 +1,87 @@
+/// \file hilbert.cpp Hilbert location tests
+#include <ndtree/location/hilbert.hpp>
+#include "test.hpp"
+
+using namespace ndtree;
+
+template struct ndtree::location::hilbert<1, uint32_t>;
+template struct ndtree::location::hilbert<2, uint32_t>;
+template struct ndtree::location::hilbert<3, uint32_t>;
+template struct ndtree::location::hilbert<1, uint64_t>;
+template struct ndtree::location::hilbert<2, uint64_t>;
+template struct ndtree::location::hilbert<3, uint64_t>;
+
+/// Checks that consecutive locations at level \p l along the Hilbert curve are
+/// face neighbors
+template <uint_t nd> void test_continuity(uint_t l) {
+  using loc_t = location::hilbert<nd>;
+  using int_t_ = loc_int_t<loc_t>;
+  std::vector<loc_t> ls;
+  std::vector<loc_t> ps{loc_t{}};
+  for (uint_t i = 0; i < l; ++i) {
+    std::vector<loc_t> cs;
+    for (auto&& p : ps) {
+      for (auto&& c : view::iota(0_u, no_children(nd))) {
+        auto tmp = p;
+        tmp.push(c);
+        cs.push_back(tmp);
+      }
+    }
+    ps = cs;
+  }
+  sort(ps);
+  for (std::size_t i = 1; i < ps.size(); ++i) {
+    std::array<int_t_, nd> a(ps[i - 1]);
+    std::array<int_t_, nd> b(ps[i]);
+    uint_t distance = 0;
+    for (auto&& d : dimensions(nd)) {
+      distance += a[d] > b[d] ? a[d] - b[d] : b[d] - a[d];
+    }
+    CHECK(distance == 1_u);
+    CHECK(ps[i].hilbert_index() == ps[i - 1].hilbert_index() + 1);
+  }
+}
+
+int main() {
+  {  // 1D (32 bit)
+    test_location<1, 31>(location::hilbert<1, uint32_t>{});
+  }
+  {  // 2D (32 bit)
+    test_location<2, 15>(location::hilbert<2, uint32_t>{});
+  }
+
+  {  // 3D (32_bit)
+    test_location<3, 9>(location::hilbert<3, uint32_t>{});
+  }
+
+  {  // 1D (64 bit)
+    test_location<1, 63>(location::hilbert<1, uint64_t>{});
+  }
+
+  {  // 2D (64 bit)
+    test_location<2, 31>(location::hilbert<2, uint64_t>{});
+  }
+
+  {  // 3D (64_bit)
+    test_location<3, 20>(location::hilbert<3, uint64_t>{});
+  }
+
+  { test_location_2<location::hilbert>(); }
+
+  {  // pop restores the orientation of the curve
+    location::hilbert<3> a({5, 2, 7, 1});
+    auto b = a;
+    b.push(3);
+    b.push(6);
+    b.pop();
+    b.pop();
+    CHECK(a == b);
+    CHECK(a.entry == b.entry);
+    CHECK(a.direction == b.direction);
+  }
+
+  test_continuity<2>(4);
+  test_continuity<3>(3);
+
+  return test::result();
+}
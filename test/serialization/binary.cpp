@@ -0,0 +1,87 @@
+/// \file binary.cpp Binary checkpoint format tests
+#include <cstdio>
+#include <vector>
+#include <ndtree/algorithm/dfs_sort.hpp>
+#include <ndtree/serialization/binary.hpp>
+#include "../test.hpp"
+#include "../tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+namespace binary = serialization::binary;
+
+/// Size of the file \p path in bytes
+long file_size(std::string const& path) {
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  std::fseek(f, 0, SEEK_END);
+  const long s = std::ftell(f);
+  std::fclose(f);
+  return s;
+}
+
+int main() {
+  const std::string path = "ndtree_serialization_binary_test.tree";
+
+  {  // raw index arrays (non-compact tree) with payloads
+    auto t = uniformly_refined_tree<2>(3, 4);
+    t.coarsen_subtree(2_n);
+    CHECK(!t.is_compact());
+    std::vector<double> d(*t.capacity());
+    std::vector<int> l(*t.capacity());
+    RANGES_FOR(auto&& n, t.nodes()) {
+      d[*n] = *n * 0.5;
+      l[*n] = node_level(t, n);
+    }
+    CHECK(binary::write(path, t, d, l));
+
+    std::vector<double> d2;
+    std::vector<int> l2;
+    auto r = binary::read<tree<2>>(path, d2, l2);
+    CHECK(static_cast<bool>(r));
+    CHECK(*r == t);
+    CHECK(r->capacity() == t.capacity());
+    CHECK(r->first_free_sibling_group() == t.first_free_sibling_group());
+    CHECK(d2.size() == *t.capacity());
+    RANGES_FOR(auto&& n, t.nodes()) {
+      CHECK(d2[*n] == d[*n]);
+      CHECK(l2[*n] == l[*n]);
+    }
+
+    // payloads must match:
+    CHECK(!binary::read<tree<2>>(path, d2));
+    CHECK(!binary::read<tree<2>>(path, l2, d2));
+    CHECK(!binary::read<tree<3>>(path, d2, l2));
+    CHECK(!binary::read<tree<2, uint16_t>>(path, d2, l2));
+
+    // compact trees are written in compacted form:
+    const long raw_size = file_size(path);
+    dfs_sort(t);
+    CHECK(t.is_compact());
+    CHECK(binary::write(path, t, d));
+    CHECK(file_size(path) < raw_size);
+    auto c = binary::read<tree<2>>(path, d2);
+    CHECK(static_cast<bool>(c));
+    CHECK(*c == t);
+    CHECK(c->capacity() == t.size());
+    CHECK(d2.size() == *t.size());
+
+    // the tree can grow after reading:
+    c->refine(first_leaf(*c));
+    CHECK(*c != t);
+  }
+
+  {  // corrupted files are detected
+    auto t = uniformly_refined_tree<3>(2, 2);
+    CHECK(binary::write(path, t));
+    CHECK(static_cast<bool>(binary::read<tree<3>>(path)));
+    std::FILE* f = std::fopen(path.c_str(), "r+b");
+    std::fseek(f, sizeof(binary::header) + 3, SEEK_SET);
+    std::fputc(0x55, f);
+    std::fclose(f);
+    CHECK(!binary::read<tree<3>>(path));
+    CHECK(!binary::read<tree<3>>(path + ".does_not_exist"));
+  }
+
+  std::remove(path.c_str());
+  return test::result();
+}
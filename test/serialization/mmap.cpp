@@ -0,0 +1,112 @@
+/// \file mmap.cpp Memory mapped tree tests
+#include <cstdio>
+#include <ndtree/algorithm/dfs_sort.hpp>
+#include <ndtree/serialization/mmap.hpp>
+#include "../test.hpp"
+#include "../tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+using mapped_tree = tree<2, uint_t, mmap_storage>;
+
+int main() {
+  const std::string path = "ndtree_serialization_mmap_test.tree";
+
+  {  // anonymous mappings are zero initialized
+    mapped_array<uint32_t> a(100);
+    CHECK(static_cast<bool>(a));
+    for (uint_t i = 0; i != 100; ++i) { CHECK(a[i] == 0_u); }
+    auto b = std::move(a);
+    CHECK(!a);
+    CHECK(static_cast<bool>(b));
+    CHECK(!mapped_array<uint32_t>(0));
+  }
+
+  {  // trees with mmap_storage behave like heap trees
+    mapped_tree t(1);
+    tree<2> u(1);
+    t.refine(0_n);
+    u.refine(0_n);
+    t.refine(std::vector<node_idx>{4_n, 1_n});
+    u.refine(std::vector<node_idx>{4_n, 1_n});
+    CHECK(t == u);
+    t.coarsen_subtree(1_n);
+    u.coarsen_subtree(1_n);
+    CHECK(t == u);
+    auto t1 = t;
+    CHECK(t1 == u);
+  }
+
+  {  // save and open
+    auto t = uniformly_refined_tree<2>(3, 3);
+    t.coarsen_subtree(2_n);
+    CHECK(serialization::mmap::save(t, path));
+
+    auto o = serialization::mmap::open<mapped_tree>(path);
+    CHECK(static_cast<bool>(o));
+    auto& m = *o;
+    CHECK(m == t);
+    CHECK(m.size() == t.size());
+    CHECK(m.capacity() == t.capacity());
+    CHECK(m.first_free_sibling_group() == t.first_free_sibling_group());
+    RANGES_FOR(auto&& n, t.nodes()) {
+      CHECK(m.parent(n) == t.parent(n));
+      CHECK(m.children_group(n) == t.children_group(n));
+    }
+
+    // the opened tree can be modified (the file is not):
+    m.refine(first_leaf(m));
+    t.refine(first_leaf(t));
+    CHECK(m == t);
+    dfs_sort(m);
+    dfs_sort(t);
+    CHECK(m == t);
+    m.reserve(*m.capacity() * 2);
+    CHECK(m == t);
+
+    auto o2 = serialization::mmap::open<mapped_tree>(path);
+    CHECK(static_cast<bool>(o2));
+    CHECK(*o2 != t);
+  }
+
+  {  // invalid files
+    CHECK(!serialization::mmap::open<mapped_tree>(path + ".does_not_exist"));
+    CHECK(!serialization::mmap::open<tree<3, uint_t, mmap_storage>>(path));
+    CHECK(!serialization::mmap::open<tree<2, uint16_t, mmap_storage>>(path));
+  }
+
+  {  // files with invalid index array offsets
+    using serialization::mmap::alignment;
+    using serialization::mmap::header;
+    header valid;
+    std::FILE* f = std::fopen(path.c_str(), "r+b");
+    CHECK(f != nullptr);
+    CHECK(std::fread(&valid, sizeof(header), 1, f) == 1_u);
+    auto open_with = [&](std::uint64_t parents_offset,
+                         std::uint64_t first_children_offset) {
+      auto h = valid;
+      h.parents_offset = parents_offset;
+      h.first_children_offset = first_children_offset;
+      std::fseek(f, 0, SEEK_SET);
+      std::fwrite(&h, sizeof(header), 1, f);
+      std::fflush(f);
+      return static_cast<bool>(serialization::mmap::open<mapped_tree>(path));
+    };
+    const auto p = valid.parents_offset;
+    const auto fc = valid.first_children_offset;
+    CHECK(open_with(p, fc));
+    CHECK(!open_with(p + 8, fc));  // misaligned
+    CHECK(!open_with(p, fc + 8));  // misaligned
+    CHECK(!open_with(0, fc));      // overlaps the header
+    CHECK(!open_with(p, p));       // overlapping arrays
+    CHECK(!open_with(p, fc + alignment()));        // beyond the end of file
+    CHECK(!open_with(fc + alignment(), fc));       // beyond the end of file
+    CHECK(!open_with(p, UINT64_MAX - alignment() + 1));  // wraps around
+    CHECK(open_with(p, fc));
+    std::fclose(f);
+  }
+
+  std::remove(path.c_str());
+  return test::result();
+}
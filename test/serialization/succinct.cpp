@@ -0,0 +1,70 @@
+/// \file succinct.cpp Succinct tree encoding tests
+#include <ndtree/algorithm/bfs_sort.hpp>
+#include <ndtree/algorithm/dfs_sort.hpp>
+#include <ndtree/serialization/succinct.hpp>
+#include "../test.hpp"
+#include "../tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+namespace succinct = serialization::succinct;
+
+void check_bits(succinct::encoding const& e, std::vector<int> bits) {
+  CHECK(e.size == bits.size());
+  for (uint_t i = 0; i != bits.size(); ++i) {
+    CHECK(e[i] == static_cast<bool>(bits[i]));
+  }
+}
+
+/// Encodes and decodes \p t in DFS and BFS order
+template <typename Tree> void check_round_trip(Tree const& t) {
+  auto dfs_sorted = t;
+  dfs_sort(dfs_sorted);
+  auto bfs_sorted = t;
+  bfs_sort(bfs_sorted);
+
+  auto d = succinct::encode(t);
+  CHECK(d.size == *t.size());
+  CHECK(d.words.size() == (*t.size() + 63) / 64);
+  auto td = succinct::decode<Tree>(d);
+  CHECK(td == dfs_sorted);
+  CHECK(td.is_compact());
+
+  auto b = succinct::encode(t, succinct::order::bfs);
+  CHECK(b.size == *t.size());
+  auto tb = succinct::decode<Tree>(b);
+  CHECK(tb == bfs_sorted);
+  CHECK(tb.is_compact());
+}
+
+int main() {
+  {  // encodings
+    tree<2> t(1);
+    t.refine(0_n);
+    t.refine(1_n);
+    t.refine(2_n);
+    check_bits(succinct::encode(t), {1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0});
+    check_bits(succinct::encode(t, succinct::order::bfs),
+               {1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+    check_round_trip(t);
+  }
+  {  // root only
+    tree<3> t(1);
+    check_bits(succinct::encode(t), {0});
+    check_round_trip(t);
+  }
+  {  // unsorted trees with holes
+    auto t = uniformly_refined_tree<2>(4, 4);
+    t.coarsen_subtree(2_n);
+    t.refine(first_leaf(t));
+    check_round_trip(t);
+
+    auto t3 = uniformly_refined_tree<3>(3, 3);
+    t3.coarsen_subtree(9_n);
+    t3.coarsen_subtree(1_n);
+    t3.refine(first_leaf(t3));
+    check_round_trip(t3);
+  }
+
+  return test::result();
+}
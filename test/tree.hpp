@@ -304,4 +304,10 @@ auto uniformly_refined_tree(uint_t level, uint_t level_capacity) -> tree<nd> {
   return t;
 }
 
+/// First leaf node of \p t
+template <typename Tree> node_idx first_leaf(Tree const& t) {
+  RANGES_FOR(auto&& n, t.nodes() | t.leaf()) { return n; }
+  return node_idx{};
+}
+
 }  // namespace test
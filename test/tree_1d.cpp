@@ -2,7 +2,10 @@
 #include <fstream>
 #include "test.hpp"
 #include "tree.hpp"
+#include <ndtree/algorithm/bfs_sort.hpp>
+#include <ndtree/algorithm/compact.hpp>
 #include <ndtree/algorithm/dfs_sort.hpp>
+#include <ndtree/algorithm/dfs_sort_permutation.hpp>
 #include <ndtree/algorithm/node_location.hpp>
 #include <ndtree/location/slim.hpp>
 
@@ -141,6 +144,89 @@ template <template <ndtree::uint_t, class...> class Loc> void test_tree() {
     CHECK(tree<1>(14).capacity() == 15_u);
     CHECK(tree<1>(15).capacity() == 15_u);
   }
+  {  // check growth
+    tree<1> t(1);
+    CHECK(t.capacity() == 1_u);
+    t.refine(0_n);
+    CHECK(t.capacity() == 3_u);
+    t.refine(1_n);
+    CHECK(t.capacity() == 7_u);
+    t.refine(2_n);
+    CHECK(t.size() == 7_u);
+    CHECK(t.capacity() == 7_u);
+    t.refine(6_n);
+    CHECK(t.capacity() == 15_u);
+    CHECK(t.is_compact());
+    CHECK(t.parent(7_n) == 6_n);
+    test::check_equal(t.children(2_n), {5_n, 6_n});
+
+    t.reserve(30);
+    CHECK(t.capacity() == 31_u);
+    t.reserve(10);
+    CHECK(t.capacity() == 31_u);
+
+    t.shrink_to_fit();
+    CHECK(t.capacity() == 9_u);
+    CHECK(t.size() == 9_u);
+    CHECK(t.is_compact());
+
+    t.coarsen(6_n);
+    t.shrink_to_fit();
+    CHECK(t.capacity() == 7_u);
+    t.coarsen(1_n);
+    t.shrink_to_fit();
+    CHECK(t.capacity() == 7_u);
+    CHECK(t.parent(5_n) == 2_n);
+  }
+  {  // check batched refine
+    tree<1> t(1);
+    CHECK(t.refine(std::vector<node_idx>{0_n}) == 1_u);
+    CHECK(t.refine(std::vector<node_idx>{2_n, 1_n}) == 2_u);
+    CHECK(t.refine(std::vector<node_idx>{6_n, 4_n, 5_n, 3_n, 6_n}) == 4_u);
+    CHECK(t.size() == 15_u);
+    CHECK(t.is_compact());
+    check_tree(t, uniform_tree{}, Loc<1>{});
+
+    // holes are filled in depth-first order:
+    t.coarsen(4_n);
+    t.coarsen(3_n);
+    CHECK(t.refine(std::vector<node_idx>{14_n, 3_n}) == 2_u);
+    CHECK(t.parent(7_n) == 3_n);
+    CHECK(t.parent(9_n) == 14_n);
+    CHECK(t.is_compact());
+  }
+  {  // check subtree and batched coarsen
+    tree<1> t(1);
+    t.refine(std::vector<node_idx>{0_n});
+    t.refine(std::vector<node_idx>{1_n, 2_n});
+    t.refine(std::vector<node_idx>{3_n, 4_n, 5_n, 6_n});
+    check_tree(t, uniform_tree{}, Loc<1>{});
+
+    std::vector<node_idx> restricted;
+    auto restriction = [&](node_idx p) {
+      CHECK(all_of(t.children(p), [&](node_idx c) { return t.is_leaf(c); }));
+      restricted.push_back(p);
+    };
+
+    t.coarsen_subtree(1_n, restriction);
+    test::check_equal(restricted, {3_n, 4_n, 1_n});
+    CHECK(t.size() == 9_u);
+    CHECK(t.is_leaf(1_n));
+    test::check_equal(t.children(2_n), {5_n, 6_n});
+
+    restricted.clear();
+    const std::vector<node_idx> ns{5_n, 2_n, 6_n, 1_n};
+    CHECK(t.coarsen(ns, restriction) == 2_u);
+    test::check_equal(restricted, {5_n, 6_n, 2_n});
+    CHECK(t.size() == 3_u);
+    CHECK(t.is_compact());
+
+    t.refine(std::vector<node_idx>{1_n, 2_n});
+    t.coarsen_subtree(0_n);
+    CHECK(t.size() == 1_u);
+    CHECK(t.is_leaf(0_n));
+    CHECK(t.is_compact());
+  }
   {
     tree<1> t(20);
     CHECK(t.capacity() == 21_u);
@@ -211,6 +297,7 @@ template <template <ndtree::uint_t, class...> class Loc> void test_tree() {
     auto t2 = t;
     CHECK(t == t2);
     CHECK(!(t != t2));
+    auto t3 = t;
 
     dfs_sort(t);
     CHECK(t != t2);
@@ -219,6 +306,56 @@ template <template <ndtree::uint_t, class...> class Loc> void test_tree() {
     check_tree(
      t, rewrite_nodes(tree_after_coarsen{}, tree_after_coarsen_sorted_map),
      Loc<1>{});
+
+    {  // compact moves the last sibling groups into the holes:
+      std::vector<Loc<1>> ls(*t2.capacity());
+      RANGES_FOR(auto&& n, t2.nodes()) {
+        ls[*n] = node_location(t2, n, Loc<1>{});
+      }
+      compact(t2, [&](node_idx a, node_idx b) { std::swap(ls[*a], ls[*b]); });
+      CHECK(t2.is_compact());
+      CHECK(t2.size() == 17_u);
+      CHECK(t2.parent(11_n) == 8_n);
+      CHECK(t2.parent(15_n) == 9_n);
+      RANGES_FOR(auto&& n, t2()) {
+        CHECK(node_location(t2, n, Loc<1>{}) == ls[*n]);
+      }
+    }
+
+    {  // bfs_sort stores the levels contiguously:
+      std::vector<Loc<1>> ls(*t2.capacity());
+      RANGES_FOR(auto&& n, t2()) { ls[*n] = node_location(t2, n, Loc<1>{}); }
+      bfs_sort(t2, [&](node_idx a, node_idx b) { std::swap(ls[*a], ls[*b]); });
+      CHECK(t2.is_compact());
+      uint_t l = 0;
+      RANGES_FOR(auto&& n, t2()) {
+        CHECK(node_location(t2, n, Loc<1>{}) == ls[*n]);
+        CHECK(node_level(t2, n) >= l);
+        l = node_level(t2, n);
+      }
+      CHECK(node_level(t2, 6_n) == 2_u);
+      CHECK(node_level(t2, 12_n) == 3_u);
+      CHECK(node_level(t2, 13_n) == 4_u);
+      test::check_equal(t2.children(6_n), {11_n, 12_n});
+    }
+
+    {  // dfs_sort_permutation produces the same tree as dfs_sort:
+      std::vector<Loc<1>> ls(*t3.capacity());
+      RANGES_FOR(auto&& n, t3.nodes()) {
+        ls[*n] = node_location(t3, n, Loc<1>{});
+      }
+      const auto perm = dfs_sort_permutation(t3);
+      CHECK(perm.size() == *t3.size());
+      CHECK(t3 == t);
+      CHECK(t3.is_compact());
+      std::vector<Loc<1>> sorted_ls(perm.size());
+      for (std::size_t i = 0; i != perm.size(); ++i) {
+        sorted_ls[i] = ls[*perm[i]];
+      }
+      RANGES_FOR(auto&& n, t3()) {
+        CHECK(node_location(t3, n, Loc<1>{}) == sorted_ls[*n]);
+      }
+    }
   }
 }
 
@@ -3,7 +3,12 @@
 #include "test.hpp"
 #include "tree.hpp"
 #include <ndtree/algorithm/dfs_sort.hpp>
+#include <ndtree/algorithm/dfs_sort_permutation.hpp>
+#include <ndtree/algorithm/hilbert_sort.hpp>
+#include <ndtree/algorithm/node_at.hpp>
 #include <ndtree/algorithm/node_location.hpp>
+#include <ndtree/algorithm/node_or_parent_at.hpp>
+#include <ndtree/location/hilbert.hpp>
 #include <ndtree/location/slim.hpp>
 
 using namespace test;
@@ -276,11 +281,287 @@ template <template <ndtree::uint_t, class...> class Loc> void test_tree() {
     CHECK(t.size() == 29_u);
     check_tree(t, tree_after_refine{}, Loc<2>{});
   }
+
+  {  // hilbert sort
+    auto t = uniformly_refined_tree<2>(2, 3);
+    t.refine(5_n);
+    t.refine(9_n);
+    t.coarsen(5_n);
+    std::vector<Loc<2>> ls(*t.capacity());
+    RANGES_FOR(auto&& n, t.nodes()) { ls[*n] = node_location(t, n, Loc<2>{}); }
+
+    hilbert_sort(t, [&](node_idx a, node_idx b) { std::swap(ls[*a], ls[*b]); });
+    CHECK(t.is_compact());
+    RANGES_FOR(auto&& n, t()) {
+      CHECK(node_location(t, n, Loc<2>{}) == ls[*n]);
+    }
+
+    // the root's children are visited in the order 0, 2, 3, 1:
+    CHECK(t.children_group(1_n) == 2_sg);
+    CHECK(t.children_group(3_n) == 3_sg);
+    CHECK(t.children_group(4_n) == 4_sg);
+    CHECK(t.children_group(2_n) == 5_sg);
+
+    // the parents of consecutive children groups at the same level are
+    // ordered along the Hilbert curve:
+    using hilbert_loc = location::hilbert<2>;
+    for (auto s = 3_sg; s != 6_sg; ++s) {
+      CHECK(hilbert_loc(node_location(t, t.parent(siblings_idx{*s - 1}),
+                                      location::slim<2>{}))
+            < hilbert_loc(node_location(t, t.parent(s), location::slim<2>{})));
+    }
+  }
+
+  {  // parallel dfs_sort_permutation
+    auto t = uniformly_refined_tree<2>(4, 5);
+    t.refine(std::vector<node_idx>{300_n, 100_n, 200_n});
+    t.coarsen_subtree(5_n);
+    t.refine(5_n);
+    t.refine(std::vector<node_idx>{85_n, 340_n});
+    CHECK(!t.is_compact());
+
+    std::vector<Loc<2>> ls(*t.capacity());
+    RANGES_FOR(auto&& n, t.nodes()) { ls[*n] = node_location(t, n, Loc<2>{}); }
+
+    auto t1 = t;
+    dfs_sort(t1);
+    const auto perm = dfs_sort_permutation(t, 4);
+    CHECK(t == t1);
+    CHECK(t.is_compact());
+    CHECK(perm.size() == *t.size());
+    RANGES_FOR(auto&& n, t()) {
+      CHECK(node_location(t, n, Loc<2>{}) == ls[*perm[*n]]);
+    }
+  }
+}
+
+/// Checks that the cached level of every node matches its location
+template <typename Loc> void check_level_cache(tree<2> const& t, Loc) {
+  CHECK(t.has_level_cache());
+  RANGES_FOR(auto&& n, t.nodes()) {
+    CHECK(t.level(n) == node_location(t, n, Loc{}).level());
+    CHECK(node_level(t, n) == t.level(n));
+  }
+}
+
+template <template <ndtree::uint_t, class...> class Loc>
+void test_level_cache() {
+  tree<2> t(1);
+  t.enable_level_cache();
+  check_level_cache(t, Loc<2>{});
+
+  // refine grows the tree (the cache is reallocated):
+  t.refine(0_n);
+  t.refine(std::vector<node_idx>{4_n, 1_n, 3_n});
+  t.refine(10_n);
+  check_level_cache(t, Loc<2>{});
+
+  // coarsen and refine into the holes:
+  t.coarsen_subtree(1_n);
+  t.refine(2_n);
+  t.refine(20_n);
+  check_level_cache(t, Loc<2>{});
+
+  // copies keep the cache, swaps move it:
+  auto t1 = t;
+  check_level_cache(t1, Loc<2>{});
+  dfs_sort(t1);
+  check_level_cache(t1, Loc<2>{});
+  dfs_sort_permutation(t);
+  check_level_cache(t, Loc<2>{});
+  CHECK(t == t1);
+
+  t.disable_level_cache();
+  CHECK(!t.has_level_cache());
+  CHECK(node_level(t, 20_n) == 4_u);
+  CHECK(node_level(t, 24_n) == 2_u);
+}
+
+template <typename Loc> void check_location_cache(tree<2> const& t, Loc) {
+  CHECK(t.has_location_cache());
+  auto u = t;
+  u.disable_location_cache();
+  RANGES_FOR(auto&& n, t.nodes()) {
+    CHECK(t.location(n) == node_location(u, n, location::slim<2>{}));
+    CHECK(node_location(t, n, Loc{}) == node_location(u, n, Loc{}));
+  }
+}
+
+template <template <ndtree::uint_t, class...> class Loc>
+void test_location_cache() {
+  tree<2> t(1);
+  t.enable_location_cache();
+  check_location_cache(t, Loc<2>{});
+
+  // refine grows the tree (the cache is reallocated):
+  t.refine(0_n);
+  t.refine(std::vector<node_idx>{4_n, 1_n, 3_n});
+  t.refine(10_n);
+  check_location_cache(t, Loc<2>{});
+  CHECK(t.location(10_n) == location::slim<2>({2, 1}));
+  CHECK(t.location(18_n) == location::slim<2>({2, 1, 1}));
+
+  // coarsen and refine into the holes:
+  t.coarsen_subtree(1_n);
+  t.refine(2_n);
+  t.refine(20_n);
+  check_location_cache(t, Loc<2>{});
+
+  // copies keep the cache, swaps and permutations move it:
+  auto t1 = t;
+  check_location_cache(t1, Loc<2>{});
+  dfs_sort(t1);
+  check_location_cache(t1, Loc<2>{});
+  dfs_sort_permutation(t);
+  check_location_cache(t, Loc<2>{});
+  CHECK(t == t1);
+
+  // both caches can be enabled at the same time:
+  t.enable_level_cache();
+  t.refine(5_n);
+  check_location_cache(t, Loc<2>{});
+  check_level_cache(t, Loc<2>{});
+
+  t.disable_location_cache();
+  CHECK(!t.has_location_cache());
+}
+
+template <typename Loc> void check_location_index(tree<2> const& t, Loc) {
+  CHECK(t.has_location_index());
+  auto u = t;
+  u.disable_location_index();
+  RANGES_FOR(auto&& n, t.nodes()) {
+    const auto l = node_location(t, n, Loc{});
+    CHECK(t.node_at(t.location(n)) == n);
+    CHECK(node_at(t, l) == n);
+    CHECK(node_at(u, l) == n);
+    CHECK(node_or_parent_at(t, l).idx == n);
+    if (t.is_leaf(n) and l.level() < 4) {
+      auto c = l;
+      c.push(3);
+      c.push(1);
+      CHECK(!node_at(t, c));
+      CHECK(node_or_parent_at(t, c).idx == n);
+      CHECK(node_or_parent_at(t, c).level == l.level());
+      CHECK(node_or_parent_at(u, c).idx == n);
+    }
+  }
+}
+
+template <template <ndtree::uint_t, class...> class Loc>
+void test_location_index() {
+  tree<2> t(1);
+  t.enable_location_index();
+  CHECK(t.has_location_cache());
+  check_location_index(t, Loc<2>{});
+
+  // refine grows the tree and the index:
+  t.refine(0_n);
+  t.refine(std::vector<node_idx>{4_n, 1_n, 3_n});
+  t.refine(10_n);
+  check_location_index(t, Loc<2>{});
+  CHECK(t.node_at(location::slim<2>({2, 1, 1})) == 18_n);
+  CHECK(!t.node_at(location::slim<2>({0, 1, 1})));
+
+  // coarsened nodes are removed from the index:
+  t.coarsen_subtree(1_n);
+  CHECK(!t.node_at(location::slim<2>({0, 1})));
+  t.refine(2_n);
+  t.refine(20_n);
+  check_location_index(t, Loc<2>{});
+
+  // copies keep the index, swaps and permutations update it:
+  auto t1 = t;
+  check_location_index(t1, Loc<2>{});
+  dfs_sort(t1);
+  check_location_index(t1, Loc<2>{});
+  dfs_sort_permutation(t);
+  check_location_index(t, Loc<2>{});
+  CHECK(t == t1);
+
+  // batched coarsening:
+  t.coarsen(std::vector<node_idx>{1_n, 2_n});
+  check_location_index(t, Loc<2>{});
+
+  // the index is released with the location cache:
+  t.disable_location_cache();
+  CHECK(!t.has_location_index());
+}
+
+/// Checks the subtree hashes of \p t against hashes computed from scratch
+void check_subtree_hashes(tree<2> const& t) {
+  CHECK(t.has_subtree_hashes());
+  auto u = t;
+  u.disable_subtree_hashes();
+  u.enable_subtree_hashes();
+  RANGES_FOR(auto&& n, t.nodes()) {
+    CHECK(t.subtree_hash(n) == u.subtree_hash(n));
+  }
+}
+
+void test_subtree_hashes() {
+  tree<2> t(1);
+  t.enable_subtree_hashes();
+  const auto leaf = t.subtree_hash(0_n);
+
+  // refine updates the hashes (and grows them with the tree):
+  t.refine(0_n);
+  CHECK(t.subtree_hash(0_n) != leaf);
+  CHECK(t.subtree_hash(1_n) == leaf);
+  t.refine(std::vector<node_idx>{4_n, 1_n, 3_n});
+  t.refine(10_n);
+  check_subtree_hashes(t);
+  CHECK(t.subtree_hash(1_n) == t.subtree_hash(4_n));
+  CHECK(t.subtree_hash(1_n) != t.subtree_hash(3_n));
+
+  // the hashes do not depend on the node indices:
+  auto u = t;
+  bfs_sort(u);
+  check_subtree_hashes(u);
+  CHECK(u.subtree_hash(0_n) == t.subtree_hash(0_n));
+
+  // changes since a checkpoint:
+  const auto checkpoint = t;
+  CHECK(t == checkpoint);
+  t.refine(18_n);
+  CHECK(t.subtree_hash(0_n) != checkpoint.subtree_hash(0_n));
+  CHECK(t != checkpoint);
+  const auto p = diff(checkpoint, t);
+  CHECK(p.refined.size() == 1_u);
+  CHECK(p.coarsened.empty());
+  CHECK(node_at(t, p.refined[0]) == 18_n);
+  t.coarsen(18_n);
+  CHECK(t.subtree_hash(0_n) == checkpoint.subtree_hash(0_n));
+  CHECK(diff(checkpoint, t).empty());
+
+  // coarsening, swaps, and permutations update the hashes:
+  t.coarsen_subtree(3_n);
+  check_subtree_hashes(t);
+  t.refine(3_n);
+  t.refine(2_n);
+  check_subtree_hashes(t);
+  dfs_sort(t);
+  check_subtree_hashes(t);
+  dfs_sort_permutation(t);
+  check_subtree_hashes(t);
+  t.coarsen(std::vector<node_idx>{1_n, 2_n});
+  check_subtree_hashes(t);
+  apply(t, diff(t, checkpoint));
+  CHECK(t.subtree_hash(0_n) == checkpoint.subtree_hash(0_n));
+
+  t.disable_subtree_hashes();
+  CHECK(!t.has_subtree_hashes());
 }
 
 int main() {
   test_tree<location::fast>();
   test_tree<location::slim>();
+  test_level_cache<location::slim>();
+  test_location_cache<location::slim>();
+  test_location_cache<location::fast>();
+  test_location_index<location::slim>();
+  test_location_index<location::fast>();
+  test_subtree_hashes();
 
   return test::result();
 }
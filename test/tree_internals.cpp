@@ -78,5 +78,41 @@ int main() {
   t.swap(1_sg, 2_sg);
   { check_tree(t, test_ns{}); }
 
+  {  // refine reuses the first free sibling group
+    tree<1> f(20);
+    for (auto n : {0_n, 1_n, 2_n, 3_n, 4_n}) { f.refine(n); }
+    CHECK(f.is_compact());
+    f.coarsen(3_n);
+    f.coarsen(2_n);
+    CHECK(!f.is_compact());
+    CHECK(f.first_free_sibling_group_ == 3_sg);
+    CHECK(f.refine(2_n) == 3_sg);
+    CHECK(f.first_free_sibling_group_ == 4_sg);
+    CHECK(f.refine(9_n) == 4_sg);
+    CHECK(f.first_free_sibling_group_ == 6_sg);
+    CHECK(f.is_compact());
+  }
+
+  {  // index storage width
+    static_assert(sizeof(tree<1, uint16_t>::index_t) == 2, "");
+    static_assert(sizeof(tree<3, uint32_t>::index_t) == 4, "");
+    static_assert(tree<1, uint8_t>::max_sibling_group_capacity() == 128_sg, "");
+
+    tree<1, uint8_t> t8(1);
+    uint_t no_refined = 0;
+    while (t8.refine(node_idx{no_refined})) { ++no_refined; }
+    CHECK(no_refined == 127_u);
+    CHECK(t8.size() == 255_u);
+    CHECK(t8.capacity() == 255_u);
+    CHECK(t8.parent(254_n) == 126_n);
+    CHECK(t8.is_leaf(127_n));
+    CHECK(t8.is_compact());
+
+    tree<1, uint32_t> t32(20);
+    t32.refine(0_n);
+    t32.refine(1_n);
+    check_tree(t32, test_ns{});
+  }
+
   return test::result();
 };
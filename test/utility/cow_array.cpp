@@ -0,0 +1,73 @@
+#include "../test.hpp"
+#include <random>
+#include <vector>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/cow_array.hpp>
+
+using namespace ndtree;
+
+/// Checks that \p a contains the same elements as the reference \p r
+template <typename A> void check(A const& a, std::vector<uint32_t> const& r) {
+  CHECK(a.size() == r.size());
+  for (uint_t i = 0; i != r.size(); ++i) { CHECK(a[i] == r[i]); }
+}
+
+int main() {
+  using array_t = cow_array<uint32_t, 8>;
+  {  // resize, push_back, pop_back
+    array_t a;
+    CHECK(a.empty());
+    a.resize(20, 3);
+    check(a, std::vector<uint32_t>(20, 3));
+    // the new chunks share memory until written:
+    CHECK(a.chunk_count() == 3_u);
+    a.set(17, 5);
+    a.push_back(7);
+    a.resize(30, 1);
+    std::vector<uint32_t> r(20, 3);
+    r[17] = 5;
+    r.push_back(7);
+    r.resize(30, 1);
+    check(a, r);
+    a.pop_back();
+    r.pop_back();
+    check(a, r);
+    a.resize(5, 0);
+    r.resize(5);
+    check(a, r);
+    CHECK(a.chunk_count() == 1_u);
+  }
+  {  // copies share chunks until they are written
+    std::mt19937 gen(7);
+    array_t a(100, 0);
+    for (uint32_t i = 0; i != 100; ++i) { a.set(i, i); }
+    std::vector<uint32_t> ra(100);
+    for (uint32_t i = 0; i != 100; ++i) { ra[i] = i; }
+
+    auto b = a;
+    auto rb = ra;
+    CHECK(a.shared_chunk_count(b) == a.chunk_count());
+    b.set(3, 1000);
+    rb[3] = 1000;
+    b.set(4, 1001);
+    rb[4] = 1001;
+    CHECK(a.shared_chunk_count(b) == a.chunk_count() - 1);
+    b.set(50, 50);  // writing the same value does not copy
+    CHECK(a.shared_chunk_count(b) == a.chunk_count() - 1);
+
+    std::uniform_int_distribution<uint32_t> pos(0, 99);
+    for (uint32_t i = 0; i != 1000; ++i) {
+      const auto p = pos(gen);
+      if (gen() % 2) {
+        a.set(p, i);
+        ra[p] = i;
+      } else {
+        b.set(p, i);
+        rb[p] = i;
+      }
+    }
+    check(a, ra);
+    check(b, rb);
+  }
+  return test::result();
+}
@@ -0,0 +1,108 @@
+#include "../test.hpp"
+#include <vector>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/hierarchical_bitset.hpp>
+
+using namespace ndtree;
+
+/// Index of the first set bit at position >= i of the reference bitset \p r
+uint_t reference_find_next(std::vector<bool> const& r, uint_t i) {
+  while (i < r.size() and !r[i]) { ++i; }
+  return i < r.size() ? i : r.size();
+}
+
+/// Index of the first unset bit at position >= i of the reference bitset \p r
+uint_t reference_find_next_unset(std::vector<bool> const& r, uint_t i) {
+  while (i < r.size() and r[i]) { ++i; }
+  return i < r.size() ? i : r.size();
+}
+
+void check_bitset(uint_t no_bits, bool value) {
+  hierarchical_bitset b(no_bits, value);
+  std::vector<bool> r(no_bits, value);
+  CHECK(b.size() == no_bits);
+  CHECK(b.none() == !value);
+  CHECK(b.find_first() == reference_find_next(r, 0));
+
+  // set and reset bits with a linear congruential sequence:
+  uint_t x = 1;
+  for (uint_t it = 0; it < 5000; ++it) {
+    x = (x * 1103515245 + 12345) % 2147483648;
+    const uint_t i = x % no_bits;
+    if ((x / no_bits) % 2) {
+      b.set(i);
+      r[i] = true;
+    } else {
+      b.reset(i);
+      r[i] = false;
+    }
+    CHECK(b.test(i) == r[i]);
+    const uint_t j = (x / 7) % (no_bits + 1);
+    CHECK(b.find_next(j) == reference_find_next(r, j));
+    CHECK(b.find_next_unset(j) == reference_find_next_unset(r, j));
+  }
+
+  // copies are deep:
+  auto c = b;
+  for (uint_t i = 0; i < no_bits; ++i) { CHECK(c.test(i) == r[i]); }
+  c.set(0);
+  b.reset(0);
+  CHECK(c.test(0));
+  CHECK(!b.test(0));
+}
+
+int main() {
+  {  // empty bitset
+    hierarchical_bitset b;
+    CHECK(b.size() == 0_u);
+    CHECK(b.none());
+    CHECK(b.find_first() == 0_u);
+    CHECK(b.find_next_unset(0) == 0_u);
+  }
+  {  // single word
+    hierarchical_bitset b(10);
+    CHECK(b.find_first() == 10_u);
+    b.set(3);
+    b.set(7);
+    CHECK(b.find_first() == 3_u);
+    CHECK(b.find_next(4) == 7_u);
+    CHECK(b.find_next(8) == 10_u);
+    CHECK(b.find_next_unset(3) == 4_u);
+    CHECK(b.find_next_unset(7) == 8_u);
+    b.reset(3);
+    CHECK(b.find_first() == 7_u);
+  }
+  {  // unset bits past the end are not found
+    hierarchical_bitset b(70, true);
+    CHECK(b.find_next_unset(0) == 70_u);
+    b.reset(65);
+    CHECK(b.find_next_unset(3) == 65_u);
+    CHECK(b.find_next_unset(66) == 70_u);
+  }
+  {  // across words and levels
+    hierarchical_bitset b(64 * 64 * 3);
+    b.set(64 * 64 * 2 + 5);
+    CHECK(b.find_first() == 64_u * 64_u * 2_u + 5_u);
+    CHECK(b.find_next(64 * 64 * 2 + 6) == b.size());
+    b.reset(64 * 64 * 2 + 5);
+    CHECK(b.none());
+  }
+  {  // reset bit ranges
+    hierarchical_bitset b(64 * 64 + 10, true);
+    b.reset(0, 64 * 64 + 3);
+    CHECK(b.find_first() == 64_u * 64_u + 3_u);
+    b.reset(5, 5);
+    b.reset(64 * 64 + 3, b.size());
+    CHECK(b.none());
+    hierarchical_bitset c(200, true);
+    c.reset(10, 130);
+    CHECK(c.find_first() == 0_u);
+    CHECK(c.find_next(10) == 130_u);
+    CHECK(c.find_next_unset(0) == 10_u);
+  }
+  for (auto&& n : {1, 2, 63, 64, 65, 4095, 4096, 4097, 270000}) {
+    check_bitset(n, false);
+    check_bitset(n, true);
+  }
+  return test::result();
+}
@@ -0,0 +1,64 @@
+#include "../test.hpp"
+#include <random>
+#include <unordered_map>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/open_hash_map.hpp>
+
+using namespace ndtree;
+
+/// Checks that \p m contains the same elements as the reference \p r
+template <typename M, typename R> void check(M const& m, R const& r) {
+  CHECK(m.size() == r.size());
+  for (auto&& kv : r) {
+    auto v = m.find(kv.first);
+    CHECK(v != nullptr);
+    if (v) { CHECK(*v == kv.second); }
+  }
+}
+
+int main() {
+  {  // empty map
+    open_hash_map<uint64_t, uint32_t> m;
+    CHECK(m.empty());
+    CHECK(m.find(1) == nullptr);
+    CHECK(!m.erase(1));
+  }
+  {  // random inserts, assignments, and erases against std::unordered_map
+    open_hash_map<uint64_t, uint32_t> m;
+    std::unordered_map<uint64_t, uint32_t> r;
+    std::mt19937 gen(7);
+    // small key range to produce collisions and reinsertions:
+    std::uniform_int_distribution<uint64_t> key(1, 2000);
+    for (uint32_t i = 0; i != 20000; ++i) {
+      const auto k = key(gen);
+      if (gen() % 3 == 0) {
+        CHECK(m.erase(k) == (r.erase(k) == 1));
+      } else {
+        m.insert_or_assign(k, i);
+        r[k] = i;
+      }
+      if (i % 1000 == 0) { check(m, r); }
+    }
+    check(m, r);
+    for (uint64_t k = 1; k <= 2000; ++k) {
+      CHECK((m.find(k) != nullptr) == (r.count(k) == 1));
+    }
+
+    auto m2 = m;
+    check(m2, r);
+    m.clear();
+    CHECK(m.empty());
+    CHECK(m.find(r.begin()->first) == nullptr);
+    check(m2, r);
+  }
+  {  // reserve
+    open_hash_map<uint32_t, uint32_t> m(100);
+    const auto c = m.capacity();
+    CHECK(c >= 200_u);
+    for (uint32_t k = 1; k <= 100; ++k) { m.insert_or_assign(k, 2 * k); }
+    CHECK(m.capacity() == c);
+    for (uint32_t k = 1; k <= 100; ++k) { CHECK(*m.find(k) == 2 * k); }
+  }
+
+  return test::result();
+}
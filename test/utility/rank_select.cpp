@@ -0,0 +1,58 @@
+#include "../test.hpp"
+#include <random>
+#include <vector>
+#include <ndtree/types.hpp>
+#include <ndtree/utility/rank_select.hpp>
+
+using namespace ndtree;
+
+/// Checks rank and select of the bitvector built from the bits \p r
+void check(std::vector<bool> const& r) {
+  std::vector<std::uint64_t> words((r.size() + 63) / 64, 0);
+  for (uint_t i = 0; i != r.size(); ++i) {
+    if (r[i]) { words[i / 64] |= std::uint64_t{1} << (i % 64); }
+  }
+  rank_select_bitvector b(words, r.size());
+  CHECK(b.size() == r.size());
+
+  uint_t ones = 0;
+  for (uint_t i = 0; i != r.size(); ++i) {
+    CHECK(b[i] == r[i]);
+    CHECK(b.rank1(i) == ones);
+    CHECK(b.rank0(i) == i - ones);
+    if (r[i]) {
+      CHECK(b.select1(ones) == i);
+      ++ones;
+    }
+  }
+  CHECK(b.rank1(r.size()) == ones);
+  CHECK(b.count() == ones);
+}
+
+int main() {
+  check({});
+  check({true});
+  check({false});
+  check(std::vector<bool>(1000, true));
+  check(std::vector<bool>(1000, false));
+
+  std::mt19937 gen(42);
+  for (double p : {0.5, 0.1, 0.001, 0.99}) {
+    std::bernoulli_distribution d(p);
+    for (uint_t n : {63, 64, 65, 511, 512, 513, 5000, 100000}) {
+      std::vector<bool> r(n);
+      for (uint_t i = 0; i != n; ++i) { r[i] = d(gen); }
+      check(r);
+    }
+  }
+
+  {  // long runs of unset bits between set bits
+    std::vector<bool> r(200000, false);
+    for (uint_t i = 0; i < 600; ++i) { r[i] = true; }
+    for (uint_t i = 150000; i < 150700; ++i) { r[i] = true; }
+    r.back() = true;
+    check(r);
+  }
+
+  return test::result();
+}
@@ -0,0 +1,110 @@
+/// \file versioned_tree.cpp Copy-on-write versioned tree tests
+#include <thread>
+#include <vector>
+#include <ndtree/versioned_tree.hpp>
+#include "test.hpp"
+#include "tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+/// Checks that the version \p v shows the same tree as \p t (with the same
+/// node indices)
+template <typename Loc = location::default_location<2>>
+void check_version(versioned_tree<2> const& v, tree<2> const& t) {
+  CHECK(v.size() == t.size());
+  CHECK(ranges::equal(v.nodes(), t.nodes()));
+  RANGES_FOR(auto&& n, t.nodes()) {
+    CHECK(v.is_leaf(n) == t.is_leaf(n));
+    CHECK(v.children_group(n) == t.children_group(n));
+    if (!t.is_root(n)) { CHECK(v.parent(n) == t.parent(n)); }
+    const auto loc = node_location(t, n, Loc{});
+    CHECK(node_location(v, n, Loc{}) == loc);
+    CHECK(node_at(v, loc) == n);
+    CHECK(ranges::equal(node_neighbors(v, loc), node_neighbors(t, loc)));
+  }
+}
+
+void test_versions() {
+  const auto t0 = uniformly_refined_tree<2>(6, 6);
+  versioned_tree<2> v0(t0);
+  check_version(v0, t0);
+  CHECK(v0.to_tree() == t0);
+
+  // a copy shares all chunks:
+  auto v1 = v0;
+  CHECK(v1.shared_chunk_count(v0) == v0.chunk_count());
+
+  // modifying it only copies the chunks written:
+  const auto a = node_at(t0, location::slim<2>({0, 1}));
+  const auto b = node_at(t0, location::slim<2>({3, 3, 3}));
+  auto t1 = t0;
+  v1.coarsen_subtree(a);
+  t1.coarsen_subtree(a);
+  v1.refine(b);
+  t1.refine(b);
+  CHECK(v1.shared_chunk_count(v0) > 0_u);
+  CHECK(v1.shared_chunk_count(v0) < v0.chunk_count());
+  check_version(v0, t0);
+  CHECK(v1.to_tree() == t1);
+
+  // versions of versions:
+  auto v2 = v1;
+  v2.coarsen(b);
+  v2.refine(b);  // reuses the sibling group released by coarsen
+  CHECK(v2.children_group(b) == v1.children_group(b));
+  CHECK(v2.to_tree() == t1);
+  v2.coarsen_subtree(0_n);
+  CHECK(v2.size() == 1_n);
+  CHECK(v2.to_tree() == tree<2>(1));
+  check_version(v0, t0);
+  CHECK(v1.to_tree() == t1);
+}
+
+void test_growth() {
+  versioned_tree<2> v;
+  tree<2> t(1);
+  CHECK(v.size() == 1_n);
+  std::vector<versioned_tree<2>> versions;
+  std::vector<tree<2>> trees;
+  for (auto n : {0_n, 1_n, 5_n, 9_n, 13_n, 17_n, 21_n}) {
+    versions.push_back(v);
+    trees.push_back(t);
+    CHECK(v.refine(n) == t.refine(n));
+  }
+  check_version(v, t);
+  for (std::size_t i = 0; i != versions.size(); ++i) {
+    CHECK(versions[i].to_tree() == trees[i]);
+  }
+}
+
+/// Threads modify their own versions of a shared tree concurrently
+void test_concurrent_versions() {
+  const auto t0 = uniformly_refined_tree<2>(4, 4);
+  const versioned_tree<2> v0(t0);
+  const auto n = node_at(t0, location::slim<2>({1}));
+  auto t1 = t0;
+  t1.coarsen_subtree(n);
+  t1.refine(n);
+  std::vector<std::thread> threads;
+  for (int i = 0; i != 4; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j != 100; ++j) {
+        auto v = v0;
+        v.coarsen_subtree(n);
+        v.refine(n);
+        CHECK(v.size() == t1.size());
+        check_version(v0, t0);
+      }
+    });
+  }
+  for (auto&& th : threads) { th.join(); }
+}
+
+int main() {
+  test_versions();
+  test_growth();
+  test_concurrent_versions();
+
+  return test::result();
+}
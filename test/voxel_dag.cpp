@@ -0,0 +1,81 @@
+/// \file voxel_dag.cpp Sparse voxel DAG tests
+#include <ndtree/voxel_dag.hpp>
+#include "test.hpp"
+#include "tree.hpp"
+
+using namespace ndtree;
+using namespace test;
+
+/// Checks that point queries on the DAG \p d of the tree \p t return the
+/// same levels and leaf payloads as on \p t
+template <int nd, typename LeafHash>
+void check_queries(tree<nd> const& t, voxel_dag<nd> const& d, LeafHash h) {
+  RANGES_FOR(auto&& n, t.nodes()) {
+    auto loc = node_location(t, n, location::default_location<nd>{});
+    if (t.is_leaf(n) and loc.level() + 1 < loc.max_level()) {
+      loc.push(0);  // query a location below the leaf
+    }
+    const auto r = node_or_parent_at(t, loc);
+    const auto rd = node_or_parent_at(d, loc);
+    CHECK(rd.level == r.level);
+    CHECK(d.is_leaf(rd.idx) == t.is_leaf(r.idx));
+    if (t.is_leaf(r.idx)) { CHECK(d.leaf_hash(rd.idx) == h(r.idx)); }
+  }
+}
+
+int main() {
+  auto no_hash = [](node_idx) { return std::uint64_t{0}; };
+
+  {  // single leaf
+    voxel_dag<2> d(tree<2>(1));
+    CHECK(d.size() == 1_n);
+    CHECK(d.is_leaf(0_n));
+    CHECK(d.leaf_hash(0_n) == 0_u);
+    CHECK(!d.child(0_n, voxel_dag<2>::child_pos{0}));
+  }
+  {  // uniform trees: one node per level
+    auto t = uniformly_refined_tree<2>(4, 4);
+    voxel_dag<2> d(t);
+    CHECK(d.no_internal_nodes() == 4_u);
+    CHECK(d.no_leaf_nodes() == 1_u);
+    test::check_equal(d.children(0_n), {1_n, 1_n, 1_n, 1_n});
+    test::check_equal(d.children(3_n), {4_n, 4_n, 4_n, 4_n});
+    CHECK(ranges::distance(d.children(4_n)) == 0);
+    check_queries(t, d, no_hash);
+
+    // leaves with different payloads:
+    auto pip = [](node_idx n) { return tree<2>::position_in_parent(n); };
+    voxel_dag<2> dp(t, pip);
+    CHECK(dp.no_internal_nodes() == 4_u);
+    CHECK(dp.no_leaf_nodes() == 4_u);
+    test::check_equal(dp.children(3_n), {4_n, 5_n, 6_n, 7_n});
+    check_queries(t, dp, pip);
+
+    auto t3 = uniformly_refined_tree<3>(5, 5);
+    voxel_dag<3> d3(t3);
+    CHECK(d3.size() == 6_n);
+    CHECK(d3.memory_usage() < *t3.size());
+  }
+  {  // non-uniform trees
+    auto t = uniformly_refined_tree<2>(4, 5);
+    t.coarsen_subtree(2_n);
+    node_idx p;  // last non-leaf node at level 2
+    RANGES_FOR(auto&& n, t.nodes()) {
+      if (node_level(t, n) == 2 and !t.is_leaf(n)) { p = n; }
+    }
+    t.coarsen_subtree(p);
+    t.refine(first_leaf(t));
+    auto lvl = [&](node_idx n) { return std::uint64_t{node_level(t, n)}; };
+    voxel_dag<2> d(t, lvl);
+    CHECK(d.size() < t.size());
+    check_queries(t, d, lvl);
+    check_queries(t, voxel_dag<2>(t), no_hash);
+
+    auto t3 = uniformly_refined_tree<3>(3, 3);
+    t3.coarsen_subtree(9_n);
+    t3.refine(first_leaf(t3));
+    check_queries(t3, voxel_dag<3>(t3), no_hash);
+  }
+
+  return test::result();
+}